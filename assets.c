@@ -0,0 +1,107 @@
+/* Generated by host/pbm2asset from the images in assets/, don't edit */
+
+#include "display.h"
+
+/* assets/font.pbm, 1024x8 */
+const uint8_t font[1024] = {
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+	0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 94, 0, 0, 0, 0,
+	0, 0, 4, 3, 4, 3, 0, 0, 0, 36, 126, 36, 36, 126, 36, 0,
+	0, 36, 74, 255, 82, 36, 0, 0, 0, 70, 38, 16, 8, 100, 98, 0,
+	0, 52, 74, 74, 52, 32, 80, 0, 0, 0, 0, 4, 3, 0, 0, 0,
+	0, 0, 0, 126, 129, 0, 0, 0, 0, 0, 0, 129, 126, 0, 0, 0,
+	0, 42, 28, 62, 28, 42, 0, 0, 0, 8, 8, 62, 8, 8, 0, 0,
+	0, 0, 0, 128, 96, 0, 0, 0, 0, 8, 8, 8, 8, 8, 0, 0,
+	0, 0, 0, 0, 96, 0, 0, 0, 0, 64, 32, 16, 8, 4, 2, 0,
+	0, 62, 65, 73, 65, 62, 0, 0, 0, 0, 66, 127, 64, 0, 0, 0,
+	0, 0, 98, 81, 73, 70, 0, 0, 0, 0, 34, 73, 73, 54, 0, 0,
+	0, 0, 14, 8, 127, 8, 0, 0, 0, 0, 35, 69, 69, 57, 0, 0,
+	0, 0, 62, 73, 73, 50, 0, 0, 0, 0, 1, 97, 25, 7, 0, 0,
+	0, 0, 54, 73, 73, 54, 0, 0, 0, 0, 6, 9, 9, 126, 0, 0,
+	0, 0, 0, 102, 0, 0, 0, 0, 0, 0, 128, 102, 0, 0, 0, 0,
+	0, 0, 8, 20, 34, 65, 0, 0, 0, 0, 20, 20, 20, 20, 0, 0,
+	0, 0, 65, 34, 20, 8, 0, 0, 0, 2, 1, 81, 9, 6, 0, 0,
+	0, 28, 34, 89, 89, 82, 12, 0, 0, 0, 126, 9, 9, 126, 0, 0,
+	0, 0, 127, 73, 73, 54, 0, 0, 0, 0, 62, 65, 65, 34, 0, 0,
+	0, 0, 127, 65, 65, 62, 0, 0, 0, 0, 127, 73, 73, 65, 0, 0,
+	0, 0, 127, 9, 9, 1, 0, 0, 0, 0, 62, 65, 81, 50, 0, 0,
+	0, 0, 127, 8, 8, 127, 0, 0, 0, 0, 65, 127, 65, 0, 0, 0,
+	0, 0, 32, 64, 64, 63, 0, 0, 0, 0, 127, 8, 20, 99, 0, 0,
+	0, 0, 127, 64, 64, 64, 0, 0, 0, 127, 2, 4, 2, 127, 0, 0,
+	0, 127, 6, 8, 48, 127, 0, 0, 0, 0, 62, 65, 65, 62, 0, 0,
+	0, 0, 127, 9, 9, 6, 0, 0, 0, 0, 62, 65, 97, 126, 64, 0,
+	0, 0, 127, 9, 9, 118, 0, 0, 0, 0, 38, 73, 73, 50, 0, 0,
+	0, 1, 1, 127, 1, 1, 0, 0, 0, 0, 63, 64, 64, 63, 0, 0,
+	0, 31, 32, 64, 32, 31, 0, 0, 0, 63, 64, 48, 64, 63, 0, 0,
+	0, 0, 119, 8, 8, 119, 0, 0, 0, 3, 4, 120, 4, 3, 0, 0,
+	0, 0, 113, 73, 73, 71, 0, 0, 0, 0, 127, 65, 65, 0, 0, 0,
+	0, 2, 4, 8, 16, 32, 64, 0, 0, 0, 0, 65, 65, 127, 0, 0,
+	0, 4, 2, 1, 2, 4, 0, 0, 0, 64, 64, 64, 64, 64, 64, 0,
+	0, 0, 1, 2, 4, 0, 0, 0, 0, 0, 48, 72, 40, 120, 0, 0,
+	0, 0, 127, 72, 72, 48, 0, 0, 0, 0, 48, 72, 72, 0, 0, 0,
+	0, 0, 48, 72, 72, 127, 0, 0, 0, 0, 48, 88, 88, 16, 0, 0,
+	0, 0, 126, 9, 1, 2, 0, 0, 0, 0, 80, 152, 152, 112, 0, 0,
+	0, 0, 127, 8, 8, 112, 0, 0, 0, 0, 0, 122, 0, 0, 0, 0,
+	0, 0, 64, 128, 128, 122, 0, 0, 0, 0, 127, 16, 40, 72, 0, 0,
+	0, 0, 0, 127, 0, 0, 0, 0, 0, 120, 8, 16, 8, 112, 0, 0,
+	0, 0, 120, 8, 8, 112, 0, 0, 0, 0, 48, 72, 72, 48, 0, 0,
+	0, 0, 248, 40, 40, 16, 0, 0, 0, 0, 16, 40, 40, 248, 0, 0,
+	0, 0, 112, 8, 8, 16, 0, 0, 0, 0, 72, 84, 84, 36, 0, 0,
+	0, 0, 8, 60, 72, 32, 0, 0, 0, 0, 56, 64, 32, 120, 0, 0,
+	0, 0, 56, 64, 56, 0, 0, 0, 0, 56, 64, 32, 64, 56, 0, 0,
+	0, 0, 72, 48, 48, 72, 0, 0, 0, 0, 24, 160, 160, 120, 0, 0,
+	0, 0, 100, 84, 84, 76, 0, 0, 0, 0, 8, 28, 34, 65, 0, 0,
+	0, 0, 0, 126, 0, 0, 0, 0, 0, 0, 65, 34, 28, 8, 0, 0,
+	0, 0, 4, 2, 4, 2, 0, 0, 0, 120, 68, 66, 68, 120, 0, 0,
+};
+
+/* assets/minifont.pbm, 36x8 */
+const uint8_t minifont[36] = {
+	31, 17, 31, 18, 31, 16, 29, 21, 23, 21, 21, 31, 7, 4, 31, 23,
+	21, 29, 31, 21, 29, 1, 1, 31, 31, 21, 31, 23, 21, 31, 25, 4,
+	19, 31, 4, 26,
+};
+
+/* assets/icon.pbm, 32x32, 128 bytes, 125 run-length coded */
+static const uint8_t asset_icon_data[] = {
+	131, 0, 24, 128, 68, 187, 160, 85, 162, 92, 40, 80, 160, 80, 160, 80,
+	160, 32, 144, 80, 8, 196, 18, 13, 1, 84, 1, 254, 128, 0, 93, 240,
+	44, 146, 197, 2, 247, 77, 178, 197, 56, 133, 58, 13, 82, 13, 18, 69,
+	40, 215, 40, 214, 41, 220, 80, 164, 43, 192, 21, 106, 144, 84, 171, 2,
+	3, 1, 2, 129, 71, 60, 203, 54, 233, 30, 228, 59, 236, 90, 181, 219,
+	109, 183, 93, 170, 247, 29, 230, 89, 175, 88, 39, 88, 167, 149, 106, 94,
+	160, 120, 164, 80, 168, 113, 132, 121, 128, 121, 134, 121, 134, 123, 196, 63,
+	228, 91, 181, 78, 185, 71, 186, 69, 186, 1, 175, 80, 38,
+};
+const struct display_asset asset_icon = {32, 4, ASSET_RLE, sizeof(asset_icon_data), asset_icon_data};
+
+/* assets/splash.pbm, 128x32, 512 bytes, 149 run-length coded */
+static const uint8_t asset_splash_data[] = {
+	147, 1, 128, 241, 131, 113, 128, 129, 137, 1, 128, 129, 131, 113, 128, 129,
+	134, 1, 128, 241, 128, 129, 131, 1, 128, 241, 137, 1, 128, 129, 131, 113,
+	128, 129, 147, 1, 129, 0, 128, 255, 140, 0, 128, 255, 131, 224, 128, 31,
+	137, 0, 128, 255, 131, 0, 128, 255, 134, 0, 128, 255, 128, 31, 128, 224,
+	128, 0, 128, 255, 137, 0, 128, 255, 131, 0, 128, 3, 140, 0, 128, 255,
+	133, 0, 128, 255, 140, 0, 128, 255, 146, 0, 128, 63, 131, 192, 128, 63,
+	134, 0, 128, 255, 131, 0, 128, 63, 128, 255, 137, 0, 128, 63, 128, 192,
+	128, 199, 128, 63, 3, 0, 0, 48, 48, 136, 0, 128, 255, 129, 0, 147,
+	128, 128, 129, 149, 128, 131, 129, 137, 128, 128, 129, 134, 128, 128, 129, 140,
+	128, 131, 129, 150, 128,
+};
+const struct display_asset asset_splash = {128, 4, ASSET_RLE, sizeof(asset_splash_data), asset_splash_data};
+
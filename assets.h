@@ -0,0 +1,13 @@
+/* Generated by host/pbm2asset from the images in assets/, don't edit */
+
+#ifndef ASSETS_HEADER
+#define ASSETS_HEADER
+
+#include "display.h"
+
+extern const uint8_t font[1024];
+extern const uint8_t minifont[36];
+extern const struct display_asset asset_icon;
+extern const struct display_asset asset_splash;
+
+#endif /* ASSETS_HEADER */
@@ -0,0 +1,91 @@
+/**
+ * boot.c
+ * Start-up, see boot.h.
+*/
+#include <stdbool.h>
+#include "boot.h"
+#include "cp0.h"
+#include "display.h"
+
+/* --------------------------------------------- */
+/* ---------------- Definitions ---------------- */
+
+/* Shorter display waits are spun through rather than filled with a job */
+#define BOOT_SPIN_US 100
+
+/* --------------------------------------------- */
+/* -------------- Local variables -------------- */
+
+static struct boot_event trace[BOOT_TRACE_EVENTS];
+static uint8_t trace_length;
+static uint32_t start_count;
+
+/* --------------------------------------------- */
+/* -------------- Local functions -------------- */
+
+/* Microseconds since boot_run() started */
+static uint32_t boot_elapsed_us(void);
+
+/* ---------------------------------------------- */
+/* ------------ Function definitions ------------ */
+
+void boot_run(void (*setup)(void), const struct boot_job *jobs, uint8_t count)
+{
+    uint32_t ready_at = 0; // When the display can take its next step
+    uint32_t now, wait;
+    uint8_t job = 0;
+    bool display_ready = false;
+
+    start_count = cp0_get_count();
+    trace_length = 0;
+    setup();
+    boot_mark("setup");
+
+    while (!display_ready || job < count)
+    {
+        now = boot_elapsed_us();
+        // The display first, its waits decide how long the start-up takes
+        if (!display_ready && now >= ready_at)
+        {
+            wait = display_init_step();
+            display_ready = wait == DISPLAY_INIT_DONE;
+            boot_mark(display_ready ? "display ready" : "display step");
+            // A job could hold up the long waits after a short one
+            if (wait < BOOT_SPIN_US)
+            {
+                cp0_delay_us(wait);
+                wait = 0;
+            }
+            ready_at = boot_elapsed_us() + wait;
+        }
+        else if (job < count)
+        {
+            jobs[job].run();
+            boot_mark(jobs[job].name);
+            job++;
+        }
+        // Nothing else to do, the wait is too short to sleep through
+        else
+            cp0_delay_us(ready_at - now);
+    }
+}
+
+void boot_mark(const char *name)
+{
+    if (trace_length >= BOOT_TRACE_EVENTS)
+        return;
+    trace[trace_length].name = name;
+    trace[trace_length].us = boot_elapsed_us();
+    trace_length++;
+}
+
+uint8_t boot_get_trace(const struct boot_event **events)
+{
+    *events = trace;
+    return trace_length;
+}
+
+static uint32_t boot_elapsed_us(void)
+{
+    return (cp0_get_count() - start_count) / CP0_TICKS_PER_US;
+}
@@ -0,0 +1,68 @@
+/**
+ * boot.h
+ *
+ * Start-up. The display's power-up sequence is mostly waiting, about
+ * 100 ms for its supply voltages to settle, so the rest of the set-up runs
+ * in those waits instead of after them. Every step is timed and kept in a
+ * trace, see boot_get_trace().
+*/
+#ifndef BOOT_HEADER
+#define BOOT_HEADER
+
+#include <stdint.h>
+
+/* --------------------------------------------- */
+/* ---------------- Definitions ---------------- */
+
+/* Most steps kept in the trace */
+#define BOOT_TRACE_EVENTS 16
+
+/* --------------------------------------------- */
+/* ----------- Variable declarations ----------- */
+
+/**
+ * @brief   A piece of set-up that doesn't need the display, run while the
+ *          display powers up.
+*/
+struct boot_job
+{
+    const char *name;
+    void (*run)(void);
+};
+
+/**
+ * @brief   When a step of the start-up finished.
+*/
+struct boot_event
+{
+    const char *name;
+    uint32_t us; // Since boot_run() started
+};
+
+/* --------------------------------------------- */
+/* ----------- Function declarations ----------- */
+
+/**
+ * @brief   Runs setup, then powers up the display with display_init_step()
+ *          and runs the jobs in order while it waits. Returns once both
+ *          are done.
+ *
+ * @param setup     what the display needs first: clocks, pins and SPI
+ * @param jobs      run in order, each once
+ * @param count     number of jobs
+*/
+void boot_run(void (*setup)(void), const struct boot_job *jobs, uint8_t count);
+
+/**
+ * @brief   Adds a step to the trace, e.g. when the first frame is sent.
+*/
+void boot_mark(const char *name);
+
+/**
+ * @brief   The steps of the start-up in the order they finished.
+ *
+ * @return  number of events
+*/
+uint8_t boot_get_trace(const struct boot_event **events);
+
+#endif /* BOOT_HEADER */
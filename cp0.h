@@ -0,0 +1,64 @@
+/**
+ * cp0.h
+ * 
+ * Access to the MIPS core's cycle counter, coprocessor 0 register 9
+ * (Count). It runs at half the system clock, 40 MHz, and wraps around
+ * after about 107 seconds, so differences between two readings are
+ * correct as long as they are taken closer than that.
+*/
+#ifndef CP0_HEADER
+#define CP0_HEADER
+
+#include <stdint.h>
+
+/* --------------------------------------------- */
+/* ---------------- Definitions ---------------- */
+
+/* Count ticks per second */
+#define CP0_COUNT_HZ 40000000
+#define CP0_TICKS_PER_US (CP0_COUNT_HZ / 1000000)
+/* CPU cycles per Count tick */
+#define CP0_CYCLES_PER_TICK 2
+
+/* --------------------------------------------- */
+/* ----------- Function declarations ----------- */
+
+#ifdef __mips__
+/**
+ * @brief   Reads the Count register.
+*/
+static inline uint32_t cp0_get_count(void)
+{
+    uint32_t count;
+    __asm__ volatile("mfc0 %0, $9" : "=r"(count));
+    return count;
+}
+
+/**
+ * @brief   Reads the EPC register, where the interrupted code continues.
+ *          Interrupts don't nest, so in a handler it is always the code
+ *          outside of interrupts.
+*/
+static inline uint32_t cp0_get_epc(void)
+{
+    uint32_t epc;
+    __asm__ volatile("mfc0 %0, $14" : "=r"(epc));
+    return epc;
+}
+#else
+/* On a PC the count is made from the system clock, see host/pic32mx.c */
+uint32_t cp0_get_count(void);
+#endif
+
+/**
+ * @brief   Spins for at least us microseconds, whatever the compiler made
+ *          of the loop. At most about 107 seconds.
+*/
+static inline void cp0_delay_us(uint32_t us)
+{
+    uint32_t start = cp0_get_count();
+    while (cp0_get_count() - start < us * CP0_TICKS_PER_US)
+        ;
+}
+
+#endif /* CP0_HEADER */
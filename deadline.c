@@ -0,0 +1,93 @@
+/**
+ * deadline.c
+ * Frame deadlines, see deadline.h.
+*/
+#include <string.h>
+#include "deadline.h"
+#include "tick.h"
+#include "cp0.h"
+
+/* --------------------------------------------- */
+/* ---------------- Definitions ---------------- */
+
+/* A shorter render drew nothing, e.g. a static screen, and says nothing
+   of what drawing costs */
+#define RENDER_MIN_US 10
+
+/* --------------------------------------------- */
+/* -------------- Local variables -------------- */
+
+static struct deadline_stats stats[DEADLINE_STATES];
+
+/* The current frame */
+static uint32_t begin_count;
+static uint32_t render_count; // When the render started, 0 if it didn't
+static bool late;
+static bool skipped;
+
+static uint8_t skips;       // Renders skipped in a row
+/* Recent times from the start of the render to the end of the frame, in
+   Count ticks, smoothed. All of it has to fit in what is left of the frame
+   when the render is decided on. */
+static uint32_t render_cost;
+
+/* ---------------------------------------------- */
+/* ------------ Function definitions ------------ */
+
+void deadline_begin(uint8_t frames)
+{
+    begin_count = cp0_get_count();
+    render_count = 0;
+    late = frames > 1;
+    skipped = false;
+}
+
+bool deadline_render_ok(void)
+{
+    uint32_t now = cp0_get_count();
+    uint32_t budget = CP0_COUNT_HZ / tick_get_rate();
+
+    // Behind, or the render would run into the next frame
+    if (skips < DEADLINE_MAX_SKIPS && (late || now - begin_count + render_cost > budget))
+    {
+        skips++;
+        skipped = true;
+        return false;
+    }
+    skips = 0;
+    render_count = now;
+    return true;
+}
+
+uint32_t deadline_end(uint8_t state)
+{
+    uint32_t now = cp0_get_count();
+    uint32_t us = (now - begin_count) / CP0_TICKS_PER_US;
+    struct deadline_stats *s;
+
+    if (render_count && now - render_count > RENDER_MIN_US * CP0_TICKS_PER_US)
+        render_cost = render_cost - render_cost / 4 + (now - render_count) / 4;
+
+    if (state >= DEADLINE_STATES)
+        return us;
+    s = &stats[state];
+    s->frames++;
+    if (us > 1000000 / tick_get_rate())
+        s->overruns++;
+    if (skipped)
+        s->skipped++;
+    if (us > s->worst_us)
+        s->worst_us = us;
+    return us;
+}
+
+void deadline_get_stats(uint8_t state, struct deadline_stats *out)
+{
+    if (state < DEADLINE_STATES)
+        *out = stats[state];
+}
+
+void deadline_reset(void)
+{
+    memset(stats, 0, sizeof(stats));
+}
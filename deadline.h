@@ -0,0 +1,84 @@
+/**
+ * deadline.h
+ *
+ * Keeps every frame of the main loop to the frame tick. Each frame is
+ * timed from when tick_wait() returns until the loop is done, against a
+ * budget of one frame period, and counted per state, see states.h.
+ *
+ * When the loop falls behind, the frame is drawn late or the drawing
+ * wouldn't fit in the time that is left, the render and flush are skipped
+ * for that tick. The game and the AI still update, the physics catches up
+ * on its own, so the game keeps its speed and only shows fewer frames. At
+ * most DEADLINE_MAX_SKIPS renders are skipped in a row.
+ *
+ *      deadline_begin()        after tick_wait()
+ *      deadline_render_ok()    before rendering
+ *      deadline_end()          at the end of the frame, after everything
+ *                              else the loop does in it
+*/
+#ifndef DEADLINE_HEADER
+#define DEADLINE_HEADER
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* --------------------------------------------- */
+/* ---------------- Definitions ---------------- */
+
+/* States counted, see states.h */
+#define DEADLINE_STATES 16
+/* Renders skipped in a row before one is drawn anyway, so the screen
+   never freezes */
+#define DEADLINE_MAX_SKIPS 3
+
+/* --------------------------------------------- */
+/* ----------- Variable declarations ----------- */
+
+/**
+ * @brief   The frames run in a state, see deadline_get_stats().
+*/
+struct deadline_stats
+{
+    uint32_t frames;
+    uint32_t overruns; // Longer than a frame period
+    uint32_t skipped;  // Renders skipped
+    uint32_t worst_us; // Longest frame
+};
+
+/* --------------------------------------------- */
+/* ----------- Function declarations ----------- */
+
+/**
+ * @brief   Starts timing a frame.
+ *
+ * @param frames    what tick_wait() returned, more than 1 if the loop was
+ *                  late
+*/
+void deadline_begin(uint8_t frames);
+
+/**
+ * @brief   Decides whether this frame is rendered.
+ *
+ * @return  false to skip the render and flush
+*/
+bool deadline_render_ok(void);
+
+/**
+ * @brief   Ends the frame and counts it.
+ *
+ * @param state     what to count the frame in, e.g. the state it ran in
+ * @return  the frame's time in microseconds
+*/
+uint32_t deadline_end(uint8_t state);
+
+/**
+ * @brief   Copies the counters of a state.
+*/
+void deadline_get_stats(uint8_t state, struct deadline_stats *stats);
+
+/**
+ * @brief   Clears the counters of every state.
+*/
+void deadline_reset(void);
+
+#endif /* DEADLINE_HEADER */
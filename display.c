@@ -11,71 +11,130 @@
  * @author Alex Lindberg
 */
 #include "display.h"
+#include "cp0.h"
+#include "profile.h"
+#include <string.h>
 
 /* --------------------------------------------- */
 /* -------------- Local variables -------------- */
 
-static uint8_t screen_data[128][4];
+/* Two frames, one to draw to and one that is being sent to the display.
+   Every column is one word, bit y of screen_data[x] is the pixel (x, y),
+   so byte j of a column is what goes into page j of the display. */
+static uint32_t frame_buffers[2][DISPLAY_WIDTH];
+static uint32_t *screen_data = frame_buffers[0];
+static uint32_t *flush_data = frame_buffers[1];
+
+/* Static parts of the screen, see display_save_background() */
+static uint32_t background[DISPLAY_WIDTH];
+
+/* Dirty column window [dirty_x0, dirty_x1) for every page, only valid when
+   the page's bit is set in dirty_pages */
+static uint8_t dirty_x0[DISPLAY_ROW_SETS];
+static uint8_t dirty_x1[DISPLAY_ROW_SETS];
+static uint8_t dirty_pages;
+
+/* Number of bytes sent to the display by the last display_update() */
+static uint16_t bytes_sent;
+
+/* Where frames are sent */
+static const struct display_backend *backend = &display_ssd1306_backend;
+/* Next step of display_init_step() */
+static uint8_t init_step;
+
+/* Where frames go in the controller's memory and which part is shown */
+static uint8_t page_base;
+static uint8_t start_line;
+static bool scrolling;
+
+/* Greyscale mode: a picture is two bitplanes, a pixel's level is
+   2 * high + low. The picture being drawn and the one being shown are
+   swapped by display_grey_present(). */
+#define GREY_LOW 0
+#define GREY_HIGH 1
+static uint32_t grey_pictures[2][2][DISPLAY_WIDTH];
+static uint32_t (*grey_draw)[DISPLAY_WIDTH] = grey_pictures[0];
+static uint32_t (*grey_show)[DISPLAY_WIDTH] = grey_pictures[1];
+/* Bitplane sent in each subframe, the high plane twice so that a pixel is
+   lit in as many subframes as its level */
+static const uint8_t grey_sequence[DISPLAY_GREY_SUBFRAMES] = {GREY_HIGH, GREY_LOW, GREY_HIGH};
+static volatile bool grey_on;
+static volatile bool grey_present_pending;
+static uint8_t grey_subframe;
+/* What the display shows, to only send the columns that change */
+static uint32_t grey_panel[DISPLAY_WIDTH];
+static bool grey_panel_known;
+static struct display_window grey_window;
+static struct display_grey_stats grey_stats;
+static uint32_t grey_start_count, grey_start_isr_cycles;
+
+/* Windows handed to an asynchronous flush */
+static struct display_window flush_window;
+
+/* CP0 Count when each page of the frame was last sent */
+static volatile uint32_t page_sent[DISPLAY_ROW_SETS];
+static void (*flush_callback)(void);
+
+/* --------------------------------------------- */
+/* -------------- Local functions -------------- */
+
+/* Adds the columns [x0, x1) of a page to the page's dirty window */
+static void display_mark_dirty(uint8_t x0, uint8_t x1, uint8_t page);
+/* Marks columns [x0, x1) dirty in every page that has bits set in changed */
+static void display_mark_dirty_columns(uint8_t x0, uint8_t x1, uint32_t changed);
+/* Sets (op=1) or clears (op=0) the bits of mask in every column of [x0, x1) */
+static void display_fill_columns(uint8_t x0, uint8_t x1, uint32_t mask, uint8_t op);
+/* Word with bits [y0, y1) set */
+static uint32_t display_row_mask(uint8_t y0, uint8_t y1);
+/* Sets the pixels of mask in column x of the greyscale picture being drawn */
+static void display_grey_set_column(uint8_t x, uint32_t mask, uint8_t level);
+/* Called by the backend when an asynchronous flush is done */
+static void display_flush_done(void);
+/* Called by the backend when an asynchronous flush has been sent */
+static void display_async_done(void);
+/* Notes that the pages with bits in pages have just been sent */
+static void display_stamp_pages(uint8_t pages);
 
 /* ---------------------------------------------- */
 /* ------------ Function definitions ------------ */
 
-void quicksleep(int cyc)
+void display_set_backend(const struct display_backend *new_backend)
 {
-	int i;
-	for (i = cyc; i > 0; i--)
-		;
+	display_update_wait();
+	backend = new_backend;
 }
 
-uint8_t spi_send_recv(uint8_t data)
+void display_init(void)
 {
-	while (!(SPI2STAT & 0x08))
-		;
-	SPI2BUF = data;
-	while (!(SPI2STAT & 1))
-		;
-	return SPI2BUF;
+	uint32_t wait;
+
+	while ((wait = display_init_step()) != DISPLAY_INIT_DONE)
+		cp0_delay_us(wait);
 }
 
-void display_init(void)
+uint32_t display_init_step(void)
 {
-	/* Apply power to display controller (VDD) */
-	DISPLAY_CHANGE_TO_COMMAND_MODE;
-	quicksleep(10);
-	DISPLAY_ACTIVATE_VDD;
-	quicksleep(1000000);
-
-	/* Turn off display */
-	spi_send_recv(0xAE);
-	DISPLAY_ACTIVATE_RESET;
-	quicksleep(10);
-	DISPLAY_DO_NOT_RESET;
-	quicksleep(10);
-
-	/* Enable 7.5 V to display */
-	spi_send_recv(0x8D);
-	spi_send_recv(0x14);
-	spi_send_recv(0xD9);
-	spi_send_recv(CMD_CHARGE_PHASE1(1) | CMD_CHARGE_PHASE2(15));
-
-	/* Apply power display (VBAT) */
-	DISPLAY_ACTIVATE_VBAT;
-	quicksleep(10000000);
-
-	/* Set COM output and scan direction */
-	spi_send_recv(0xA1);
-	spi_send_recv(0xC8);
-
-	/* Set COM pins */
-	spi_send_recv(0xDA);
-	spi_send_recv(0x20);
-
-	/* Turn on display */
-	spi_send_recv(0xAF);
-
-	/* Clear out graphic RAM */
+	uint32_t wait = DISPLAY_INIT_DONE;
+
+	if (backend->init_step)
+		wait = backend->init_step(init_step++);
+	else
+		backend->init();
+	if (wait != DISPLAY_INIT_DONE)
+		return wait;
+
+	init_step = 0;
+	page_base = 0;
+	start_line = 0;
+	scrolling = false;
+	if (backend->set_page_base)
+		backend->set_page_base(0);
+
+	/* Clear out graphic RAM, its contents are undefined after power up */
 	display_clear_screen();
+	display_invalidate();
 	display_update();
+	return DISPLAY_INIT_DONE;
 }
 
 void display_set_pixel(uint8_t x, uint8_t y, uint8_t op)
@@ -84,84 +143,71 @@ void display_set_pixel(uint8_t x, uint8_t y, uint8_t op)
 	if (x < 0 || x > DISPLAY_WIDTH - 1 || y < 0 || y > DISPLAY_HEIGHT - 1)
 		return;
 
-	/* Which row relative to the screen columns  */
-	uint8_t current_bit = y % DISPLAY_ROW_BITS;
-	/* Which set of rows */
-	uint8_t current_row_set = (y - current_bit) / DISPLAY_ROW_BITS;
+	uint32_t old_data = screen_data[x];
 
 	/* Set the pixel in screen_data, 1 if op=SET, 0 if op=CLR  */
 	switch (op)
 	{
 	case 1:
-		screen_data[x][current_row_set] |= 0x1 << current_bit;
+		screen_data[x] |= (uint32_t)0x1 << y;
 		break;
 	default:
-		screen_data[x][current_row_set] &= ~(0x1 << current_bit);
+		screen_data[x] &= ~((uint32_t)0x1 << y);
 		break;
 	}
+
+	/* Only pixels that actually changed have to be sent to the display */
+	if (screen_data[x] != old_data)
+		display_mark_dirty(x, x + 1, y / DISPLAY_ROW_BITS);
 }
 
 void display_clear_screen()
 {
-	uint8_t i, j;
-	for (j = 0; j < DISPLAY_ROW_SETS; j++)
-	{
-		for (i = 0; i < DISPLAY_WIDTH; i++)
-		{
-			screen_data[i][j] = 0x00;
-		}
-	}
+	display_fill_columns(0, DISPLAY_WIDTH, 0xFFFFFFFF, 0);
 }
 
+/*
+	The width and height are computed modulo 256, like they always have
+	been, so that an end coordinate of 128 (which wraps to -128 as an int8_t)
+	still reaches the right edge of the screen. Rectangles starting left of
+	or above the screen are not drawn. */
 void display_draw_filled_rect(int8_t x0, int8_t y0,
 							  int8_t x1, int8_t y1, uint8_t op)
 {
 	uint8_t width = x1 - x0;
 	uint8_t height = y1 - y0;
-	uint8_t i, j;
 
-	/* Check that width and height is non-negative */
-	if (width < 0 || height < 0)
+	if (x0 < 0 || y0 < 0 || x0 >= DISPLAY_WIDTH || y0 >= DISPLAY_HEIGHT)
 		return;
 
-	/* Draw rectangle to screen */
-	for (i = x0; (i < (x0 + width)) && (i < DISPLAY_WIDTH); i++)
-	{
-		for (j = y0; (j < (y0 + height)) && (j < DISPLAY_HEIGHT); j++)
-			display_set_pixel(i, j, op);
-	}
+	/* One masked operation per column */
+	display_fill_columns(x0, (x0 + width < DISPLAY_WIDTH) ? x0 + width : DISPLAY_WIDTH,
+						 display_row_mask(y0, (y0 + height < DISPLAY_HEIGHT) ? y0 + height : DISPLAY_HEIGHT),
+						 op);
 }
 
 void display_draw_horizontal_line(int8_t x0, int8_t x1, int8_t y, uint8_t op)
 {
 	uint8_t width = x1 - x0;
-	uint8_t i, j;
 
-	/* Check that width and height is non-negative */
-	if (width < 0 || y > 31 || y < 0)
+	if (x0 < 0 || x0 >= DISPLAY_WIDTH || y > 31 || y < 0)
 		return;
 
-	/* Draw rectangle to screen */
-	for (i = x0; (i < (x0 + width)) && (i < DISPLAY_WIDTH); i++)
-	{
-		display_set_pixel(i, y, op);
-	}
+	display_fill_columns(x0, (x0 + width < DISPLAY_WIDTH) ? x0 + width : DISPLAY_WIDTH,
+						 (uint32_t)0x1 << y, op);
 }
 
 void display_draw_vertical_line(int8_t y0, int8_t y1, int8_t x, uint8_t op)
 {
 	uint8_t height = y1 - y0;
-	uint8_t i, j;
 
-	/* Check that width and height is non-negative */
-	if (height < 0 || x > 127 || x < 0)
+	if (y0 < 0 || y0 >= DISPLAY_HEIGHT || x > 127 || x < 0)
 		return;
 
-	/* Draw rectangle to screen */
-	for (i = y0; (i < (y0 + height)) && (i < DISPLAY_HEIGHT); i++)
-	{
-		display_set_pixel(x, i, op);
-	}
+	/* A vertical span is a single masked operation */
+	display_fill_columns(x, x + 1,
+						 display_row_mask(y0, (y0 + height < DISPLAY_HEIGHT) ? y0 + height : DISPLAY_HEIGHT),
+						 op);
 }
 
 void display_draw_empty_rect(int8_t x0, int8_t y0,
@@ -173,77 +219,767 @@ void display_draw_empty_rect(int8_t x0, int8_t y0,
 	display_draw_vertical_line(y0, y1, x1, op);
 }
 
-void display_update(void)
+void display_sprite_from_pages(struct display_sprite *sprite, const uint8_t *data,
+							   uint8_t width, uint8_t height)
 {
-	int i, j, k, c;
-	for (j = 0; j < 4; j++)
+	/* A larger bitmap is cut to the top left of it, its pages are still
+	   stride bytes apart */
+	uint8_t stride = width;
+	uint8_t i, j, pages;
+
+	if (width > DISPLAY_SPRITE_MAX_WIDTH)
+		width = DISPLAY_SPRITE_MAX_WIDTH;
+	if (height > DISPLAY_HEIGHT)
+		height = DISPLAY_HEIGHT;
+	pages = (height + DISPLAY_ROW_BITS - 1) / DISPLAY_ROW_BITS;
+	sprite->width = width;
+	sprite->height = height;
+
+	/* Page j of the bitmap becomes byte j of every column */
+	for (i = 0; i < width; i++)
 	{
-		DISPLAY_CHANGE_TO_COMMAND_MODE;
-		quicksleep(10);
+		sprite->columns[i] = 0;
+		for (j = 0; j < pages; j++)
+			sprite->columns[i] |= (uint32_t)data[j * stride + i] << (DISPLAY_ROW_BITS * j);
+		sprite->columns[i] &= display_row_mask(0, height);
+	}
+}
 
-		spi_send_recv(0x22);
-		spi_send_recv(j);
+void display_sprite_filled(struct display_sprite *sprite, uint8_t width, uint8_t height)
+{
+	uint8_t i;
 
-		spi_send_recv(0x0);
-		spi_send_recv(0x10);
+	if (width > DISPLAY_SPRITE_MAX_WIDTH)
+		width = DISPLAY_SPRITE_MAX_WIDTH;
+	if (height > DISPLAY_HEIGHT)
+		height = DISPLAY_HEIGHT;
+	sprite->width = width;
+	sprite->height = height;
 
-		DISPLAY_CHANGE_TO_DATA_MODE;
-		quicksleep(10);
+	for (i = 0; i < width; i++)
+		sprite->columns[i] = display_row_mask(0, height);
+}
 
-		for (i = 0; i < DISPLAY_WIDTH; i++)
+/*
+	A sprite column is shifted into place with one shift, whatever the
+	vertical offset, so there is no need for pre-shifted copies. */
+void display_blit(const struct display_sprite *sprite, int x, int y, uint8_t rop)
+{
+	uint32_t data, old_data, changed = 0;
+	int i, first = DISPLAY_WIDTH, last = 0;
+
+	/* Entirely outside the screen */
+	if (y <= -DISPLAY_HEIGHT || y >= DISPLAY_HEIGHT ||
+		x + sprite->width <= 0 || x >= DISPLAY_WIDTH)
+		return;
+
+	for (i = (x < 0) ? -x : 0; i < sprite->width && x + i < DISPLAY_WIDTH; i++)
+	{
+		/* Rows below the screen are shifted out of the word */
+		data = (y >= 0) ? sprite->columns[i] << y : sprite->columns[i] >> -y;
+		old_data = screen_data[x + i];
+
+		switch (rop)
 		{
-			spi_send_recv(screen_data[i][j]);
+		case BLIT_SET:
+			screen_data[x + i] |= data;
+			break;
+		case BLIT_CLR:
+			screen_data[x + i] &= ~data;
+			break;
+		default:
+			screen_data[x + i] ^= data;
+			break;
+		}
+
+		if (screen_data[x + i] != old_data)
+		{
+			changed |= screen_data[x + i] ^ old_data;
+			if (x + i < first)
+				first = x + i;
+			last = x + i;
 		}
 	}
+
+	if (changed)
+		display_mark_dirty_columns(first, last + 1, changed);
 }
 
-/* ---------------- Code from mipslabfunc.c ---------------- */
-void display_print_text(char *str, int x, int y)
+void display_save_background(void)
 {
-	/* if the string is empty or we are trying to print outside the screen, return */
-	if (!str || x < 0 || x > (127 - 8) || y < 0 || y > (31 - 8))
+	memcpy(background, screen_data, sizeof(background));
+}
+
+void display_restore_background(int x, int y, int width, int height)
+{
+	uint32_t mask, old_data, changed = 0;
+	int i, first = DISPLAY_WIDTH, last = 0;
+
+	/* Clip to the screen */
+	if (x < 0)
+	{
+		width += x;
+		x = 0;
+	}
+	if (y < 0)
+	{
+		height += y;
+		y = 0;
+	}
+	if (x + width > DISPLAY_WIDTH)
+		width = DISPLAY_WIDTH - x;
+	if (y + height > DISPLAY_HEIGHT)
+		height = DISPLAY_HEIGHT - y;
+	if (width <= 0 || height <= 0)
 		return;
 
-	int current_row_set, col, row;
-	int n; /* number of characters printed */
-	/* Copy string to screen buffer */
-	for (n = 0; n < 16; n++)
+	mask = display_row_mask(y, y + height);
+	for (i = x; i < x + width; i++)
 	{
-		/* Copy bitmap data to screen buffer */
-		for (col = 0; col < 8; col++)
+		old_data = screen_data[i];
+		screen_data[i] = (old_data & ~mask) | (background[i] & mask);
+
+		if (screen_data[i] != old_data)
 		{
-			/* Get 8 pixel high row set from character bitmap */
-			current_row_set = font[(*str) * 8 + col];
+			changed |= screen_data[i] ^ old_data;
+			if (i < first)
+				first = i;
+			last = i;
+		}
+	}
+
+	if (changed)
+		display_mark_dirty_columns(first, last + 1, changed);
+}
+
+void display_put_columns(const uint32_t *columns, int x, int width, uint32_t mask)
+{
+	uint32_t old_data, changed = 0;
+	int i, first = DISPLAY_WIDTH, last = 0;
+
+	for (i = (x < 0) ? -x : 0; i < width && x + i < DISPLAY_WIDTH; i++)
+	{
+		old_data = screen_data[x + i];
+		screen_data[x + i] = (old_data & ~mask) | (columns[i] & mask);
 
-			/* Copy current current row set to screen buffer */
-			for (row = 0; row < 8; row++)
+		if (screen_data[x + i] != old_data)
+		{
+			changed |= screen_data[x + i] ^ old_data;
+			if (x + i < first)
+				first = x + i;
+			last = x + i;
+		}
+	}
+
+	if (changed)
+		display_mark_dirty_columns(first, last + 1, changed);
+}
+
+void display_asset_open(struct display_asset_reader *reader, const struct display_asset *asset)
+{
+	reader->next = asset->data;
+	reader->count = 0;
+	reader->repeat = false;
+	reader->rle = asset->flags & ASSET_RLE;
+}
+
+uint8_t display_asset_read(struct display_asset_reader *reader)
+{
+	uint8_t c;
+
+	if (!reader->rle)
+		return *reader->next++;
+
+	/* A byte c below 0x80 is followed by c + 1 bytes to copy, from 0x80 up
+	   by one byte to repeat (c & 0x7F) + 3 times */
+	if (!reader->count)
+	{
+		c = *reader->next++;
+		reader->repeat = c & 0x80;
+		reader->count = reader->repeat ? (c & 0x7F) + 3 : c + 1;
+	}
+	reader->count--;
+
+	if (!reader->repeat || !reader->count)
+		return *reader->next++;
+	return *reader->next;
+}
+
+void display_draw_asset(const struct display_asset *asset, int x, int y)
+{
+	struct display_asset_reader reader;
+	uint32_t data, mask, old_data, changed = 0;
+	int i, j, row, first = DISPLAY_WIDTH, last = 0;
+
+	display_asset_open(&reader, asset);
+	for (j = 0; j < asset->pages; j++)
+	{
+		row = y + j * DISPLAY_ROW_BITS;
+		for (i = 0; i < asset->width; i++)
+		{
+			/* Every byte has to be read to get to the next ones */
+			data = display_asset_read(&reader);
+			if (x + i < 0 || x + i >= DISPLAY_WIDTH || row <= -DISPLAY_ROW_BITS || row >= DISPLAY_HEIGHT)
+				continue;
+
+			mask = 0xFF;
+			if (row >= 0)
+			{
+				data <<= row;
+				mask <<= row;
+			}
+			else
+			{
+				data >>= -row;
+				mask >>= -row;
+			}
+
+			old_data = screen_data[x + i];
+			screen_data[x + i] = (old_data & ~mask) | data;
+			if (screen_data[x + i] != old_data)
+			{
+				changed |= screen_data[x + i] ^ old_data;
+				if (x + i < first)
+					first = x + i;
+				if (x + i > last)
+					last = x + i;
+			}
+		}
+	}
+
+	if (changed)
+		display_mark_dirty_columns(first, last + 1, changed);
+}
+
+uint16_t display_stream_asset(const struct display_asset *asset, uint8_t x, uint8_t page)
+{
+	uint16_t sent;
+	uint8_t j;
+
+	if (x + asset->width > DISPLAY_WIDTH || page + asset->pages > DISPLAY_ROW_SETS)
+		return 0;
+	if (grey_on)
+		return 0;
+
+	if (!backend->stream)
+	{
+		display_draw_asset(asset, x, page * DISPLAY_ROW_BITS);
+		display_update();
+		return bytes_sent;
+	}
+
+	display_update_wait();
+	display_scroll_stop();
+	sent = backend->stream(asset, x, page);
+
+	/* The display no longer shows the screen data buffer there */
+	for (j = page; j < page + asset->pages; j++)
+		display_mark_dirty(x, x + asset->width, j);
+	return sent;
+}
+
+void display_grey_enable(bool on)
+{
+	if (on == grey_on)
+		return;
+
+	display_update_wait();
+	display_scroll_stop();
+	if (on)
+	{
+		grey_subframe = 0;
+		grey_present_pending = false;
+		grey_panel_known = false;
+		memset(&grey_stats, 0, sizeof(grey_stats));
+		grey_start_count = cp0_get_count();
+		grey_start_isr_cycles = display_spi_isr_cycles;
+		grey_on = true;
+	}
+	else
+	{
+		grey_on = false;
+		/* A subframe may have been started just before */
+		display_update_wait();
+		display_invalidate();
+	}
+}
+
+bool display_grey_enabled(void)
+{
+	return grey_on;
+}
+
+void display_grey_tick(void)
+{
+	uint32_t start = cp0_get_count();
+	uint32_t (*swap)[DISPLAY_WIDTH];
+	const uint32_t *plane;
+	uint32_t changed;
+	uint8_t x, j;
+
+	if (!grey_on)
+		return;
+	if (display_update_busy())
+	{
+		grey_stats.overruns++;
+		return;
+	}
+
+	/* A new picture is only taken at the start of a greyscale frame, so
+	   that every frame shows all the subframes of one picture */
+	if (grey_subframe == 0 && grey_present_pending)
+	{
+		swap = grey_show;
+		grey_show = grey_draw;
+		grey_draw = swap;
+		grey_present_pending = false;
+	}
+	plane = grey_show[grey_sequence[grey_subframe]];
+	if (++grey_subframe == DISPLAY_GREY_SUBFRAMES)
+		grey_subframe = 0;
+
+	/* Only the columns of each page that differ from what is shown */
+	grey_window.pages = 0;
+	for (x = 0; x < DISPLAY_WIDTH; x++)
+	{
+		changed = grey_panel_known ? plane[x] ^ grey_panel[x] : 0xFFFFFFFF;
+		if (!changed)
+			continue;
+		for (j = 0; j < DISPLAY_ROW_SETS; j++)
+		{
+			if (!(changed & ((uint32_t)0xFF << (DISPLAY_ROW_BITS * j))))
+				continue;
+			if (!(grey_window.pages & (1 << j)))
+			{
+				grey_window.pages |= 1 << j;
+				grey_window.x0[j] = x;
+			}
+			grey_window.x1[j] = x + 1;
+		}
+	}
+	memcpy(grey_panel, plane, sizeof(grey_panel));
+	grey_panel_known = true;
+
+	/* The plane isn't touched before the next swap, which waits for the
+	   flush to finish, so it can be sent as it is */
+	if (grey_window.pages)
+	{
+		if (backend->flush_async)
+			grey_stats.bytes += backend->flush_async(plane, &grey_window, NULL);
+		else
+		{
+			for (j = 0; j < DISPLAY_ROW_SETS; j++)
 			{
-				/* If pixel in the current row set is 1, set it to 1 in the buffer */
-				if ((current_row_set >> row) & 0x1)
-					display_set_pixel(x + 8 * n + col, y + row, 1);
+				if (grey_window.pages & (1 << j))
+					grey_stats.bytes += backend->flush_region(plane, j, grey_window.x0[j], grey_window.x1[j]);
 			}
 		}
-		*str++; // next character in the string
 	}
+	grey_stats.subframes++;
+	grey_stats.tick_cycles += cp0_get_count() - start;
+}
+
+void display_grey_clear(void)
+{
+	memset(grey_draw, 0, sizeof(grey_pictures[0]));
+}
+
+void display_grey_set_pixel(uint8_t x, uint8_t y, uint8_t level)
+{
+	if (x >= DISPLAY_WIDTH || y >= DISPLAY_HEIGHT)
+		return;
+	display_grey_set_column(x, (uint32_t)1 << y, level);
+}
+
+void display_grey_fill_rect(int x0, int y0, int x1, int y1, uint8_t level)
+{
+	uint32_t mask;
+	int x;
+
+	if (x0 < 0)
+		x0 = 0;
+	if (y0 < 0)
+		y0 = 0;
+	if (x1 >= DISPLAY_WIDTH)
+		x1 = DISPLAY_WIDTH - 1;
+	if (y1 >= DISPLAY_HEIGHT)
+		y1 = DISPLAY_HEIGHT - 1;
+	if (x0 > x1 || y0 > y1)
+		return;
+
+	mask = display_row_mask(y0, y1 + 1);
+	for (x = x0; x <= x1; x++)
+		display_grey_set_column(x, mask, level);
+}
+
+void display_grey_blit(const struct display_sprite *sprite, int x, int y, uint8_t level)
+{
+	uint32_t data;
+	int i;
+
+	/* Entirely outside the screen */
+	if (y <= -DISPLAY_HEIGHT || y >= DISPLAY_HEIGHT ||
+		x + sprite->width <= 0 || x >= DISPLAY_WIDTH)
+		return;
+
+	for (i = (x < 0) ? -x : 0; i < sprite->width && x + i < DISPLAY_WIDTH; i++)
+	{
+		data = (y >= 0) ? sprite->columns[i] << y : sprite->columns[i] >> -y;
+		display_grey_set_column(x + i, data, level);
+	}
+}
+
+void display_grey_draw_screen(uint8_t level)
+{
+	uint8_t x;
+	for (x = 0; x < DISPLAY_WIDTH; x++)
+		display_grey_set_column(x, screen_data[x], level);
+}
+
+void display_grey_present(void)
+{
+	grey_present_pending = true;
+}
+
+bool display_grey_presenting(void)
+{
+	return grey_present_pending;
+}
+
+void display_grey_get_stats(struct display_grey_stats *stats)
+{
+	*stats = grey_stats;
+	stats->isr_cycles = display_spi_isr_cycles - grey_start_isr_cycles;
+	stats->elapsed = cp0_get_count() - grey_start_count;
+}
+
+void display_update(void)
+{
+	int j;
+	/* The greyscale subframes own the display */
+	if (grey_on)
+		return;
+	/* Let an asynchronous flush finish before using the display */
+	display_update_wait();
+	display_scroll_stop();
+
+	bytes_sent = 0;
+	for (j = 0; j < DISPLAY_ROW_SETS; j++)
+	{
+		if ((dirty_pages & (1 << j)) && (dirty_x0[j] != 0 || dirty_x1[j] != DISPLAY_WIDTH))
+			break;
+	}
+
+	/* Everything changed */
+	if (dirty_pages == (1 << DISPLAY_ROW_SETS) - 1 && j == DISPLAY_ROW_SETS)
+	{
+		bytes_sent = backend->flush(screen_data);
+		display_stamp_pages(dirty_pages);
+		dirty_pages = 0;
+		return;
+	}
+
+	for (j = 0; j < DISPLAY_ROW_SETS; j++)
+	{
+		/* Pages that haven't changed since the last update are skipped */
+		if (dirty_pages & (1 << j))
+		{
+			bytes_sent += backend->flush_region(screen_data, j, dirty_x0[j], dirty_x1[j]);
+			display_stamp_pages(1 << j);
+		}
+	}
+	dirty_pages = 0;
 }
 
-void display_image(int x, const uint8_t *data)
+void display_update_async(void)
 {
-	int i, j;
+	uint32_t *swap;
+	uint8_t j;
 
-	for (i = 0; i < 4; i++)
+	if (grey_on)
+		return;
+	/* Only one frame can be on its way to the display */
+	display_update_wait();
+	display_scroll_stop();
+
+	bytes_sent = 0;
+	if (!dirty_pages || !backend->flush_async)
 	{
-		DISPLAY_CHANGE_TO_COMMAND_MODE;
+		display_update();
+		display_flush_done();
+		return;
+	}
 
-		spi_send_recv(0x22);
-		spi_send_recv(i);
+	/* The finished frame is sent from flush_data while the next one is drawn
+	   on top of a copy of it, so drawing works just like with one buffer */
+	swap = flush_data;
+	flush_data = screen_data;
+	screen_data = swap;
+	memcpy(screen_data, flush_data, sizeof(frame_buffers[0]));
 
-		spi_send_recv(x & 0xF);
-		spi_send_recv(0x10 | ((x >> 4) & 0xF));
+	/* Hand the dirty windows over to the flush */
+	flush_window.pages = dirty_pages;
+	for (j = 0; j < DISPLAY_ROW_SETS; j++)
+	{
+		flush_window.x0[j] = dirty_x0[j];
+		flush_window.x1[j] = dirty_x1[j];
+	}
+	dirty_pages = 0;
+
+	bytes_sent = backend->flush_async(flush_data, &flush_window, display_async_done);
+}
 
-		DISPLAY_CHANGE_TO_DATA_MODE;
+bool display_update_busy(void)
+{
+	return backend->busy && backend->busy();
+}
 
-		for (j = 0; j < 32; j++)
-			spi_send_recv(~data[i * 32 + j]);
+void display_update_wait(void)
+{
+	while (display_update_busy())
+		;
+}
+
+void display_set_flush_callback(void (*callback)(void))
+{
+	flush_callback = callback;
+}
+
+void display_invalidate(void)
+{
+	uint8_t j;
+	for (j = 0; j < DISPLAY_ROW_SETS; j++)
+	{
+		dirty_x0[j] = 0;
+		dirty_x1[j] = DISPLAY_WIDTH;
 	}
+	dirty_pages = (1 << DISPLAY_ROW_SETS) - 1;
+}
+
+uint32_t display_get_page_sent(uint8_t page)
+{
+	return page_sent[page];
+}
+
+uint16_t display_get_bytes_sent(void)
+{
+	return bytes_sent;
+}
+
+void display_set_page_base(uint8_t page)
+{
+	page &= DISPLAY_MEMORY_PAGES - 1;
+	if (page == page_base)
+		return;
+
+	display_update_wait();
+	display_scroll_stop();
+	page_base = page;
+	if (backend->set_page_base)
+		backend->set_page_base(page);
+	/* Nothing is known about what the new pages hold */
+	display_invalidate();
+}
+
+uint8_t display_get_page_base(void)
+{
+	return page_base;
+}
+
+void display_set_start_line(uint8_t line)
+{
+	line &= DISPLAY_MEMORY_LINES - 1;
+	if (line == start_line)
+		return;
+
+	display_update_wait();
+	start_line = line;
+	if (backend->set_start_line)
+		backend->set_start_line(line);
+}
+
+uint8_t display_get_start_line(void)
+{
+	return start_line;
+}
+
+bool display_move_start_line(uint8_t target, uint8_t step)
+{
+	uint8_t line = start_line;
+
+	target &= DISPLAY_MEMORY_LINES - 1;
+	if (line < target)
+		line = target - line > step ? line + step : target;
+	else if (line > target)
+		line = line - target > step ? line - step : target;
+
+	display_set_start_line(line);
+	return start_line == target;
+}
+
+void display_scroll_horizontal(bool left, uint8_t page0, uint8_t page1, uint8_t interval)
+{
+	if (!backend->scroll)
+		return;
+
+	display_update_wait();
+	backend->scroll(left ? -1 : 1, page0, page1, interval);
+	scrolling = true;
+}
+
+void display_scroll_stop(void)
+{
+	if (!scrolling)
+		return;
+
+	display_update_wait();
+	backend->scroll(0, 0, 0, 0);
+	scrolling = false;
+	display_invalidate();
+}
+
+static void display_flush_done(void)
+{
+	if (flush_callback)
+		flush_callback();
+}
+
+static void display_async_done(void)
+{
+	display_stamp_pages(flush_window.pages);
+	display_flush_done();
+}
+
+static void display_stamp_pages(uint8_t pages)
+{
+	uint32_t now = cp0_get_count();
+	uint8_t j;
+
+	for (j = 0; j < DISPLAY_ROW_SETS; j++)
+		if (pages & (1 << j))
+			page_sent[j] = now;
+}
+
+static void display_mark_dirty_columns(uint8_t x0, uint8_t x1, uint32_t changed)
+{
+	uint8_t j;
+	for (j = 0; j < DISPLAY_ROW_SETS; j++)
+	{
+		if (changed & ((uint32_t)0xFF << (DISPLAY_ROW_BITS * j)))
+			display_mark_dirty(x0, x1, j);
+	}
+}
+
+static void display_fill_columns(uint8_t x0, uint8_t x1, uint32_t mask, uint8_t op)
+{
+	uint32_t old_data, changed = 0;
+	uint8_t i, first = x1, last = x0;
+	for (i = x0; i < x1; i++)
+	{
+		old_data = screen_data[i];
+		if (op)
+			screen_data[i] |= mask;
+		else
+			screen_data[i] &= ~mask;
+
+		/* Remember which rows and columns changed, marked once for the span */
+		if (screen_data[i] != old_data)
+		{
+			changed |= screen_data[i] ^ old_data;
+			if (i < first)
+				first = i;
+			last = i;
+		}
+	}
+
+	if (changed)
+		display_mark_dirty_columns(first, last + 1, changed);
+}
+
+static uint32_t display_row_mask(uint8_t y0, uint8_t y1)
+{
+	uint32_t upper = (y1 >= 32) ? 0xFFFFFFFF : ((uint32_t)0x1 << y1) - 1;
+	return upper & ~(((uint32_t)0x1 << y0) - 1);
+}
+
+static void display_mark_dirty(uint8_t x0, uint8_t x1, uint8_t page)
+{
+	/* First change in this page, the window is just these columns */
+	if (!(dirty_pages & (1 << page)))
+	{
+		dirty_pages |= 1 << page;
+		dirty_x0[page] = x0;
+		dirty_x1[page] = x1;
+		return;
+	}
+
+	if (x0 < dirty_x0[page])
+		dirty_x0[page] = x0;
+	if (x1 > dirty_x1[page])
+		dirty_x1[page] = x1;
+}
+
+static void display_grey_set_column(uint8_t x, uint32_t mask, uint8_t level)
+{
+	grey_draw[GREY_LOW][x] = (level & 1) ? grey_draw[GREY_LOW][x] | mask : grey_draw[GREY_LOW][x] & ~mask;
+	grey_draw[GREY_HIGH][x] = (level & 2) ? grey_draw[GREY_HIGH][x] | mask : grey_draw[GREY_HIGH][x] & ~mask;
+}
+
+/* ---------------- Code from mipslabfunc.c ---------------- */
+/*
+	The font is stored in the display's page format, one byte per glyph
+	column, so a glyph column is placed at any y with one shift and OR'd
+	into the screen word. Text is OR'd onto what is already there. */
+void display_print_text(char *str, int x, int y)
+{
+	/* if the string is empty or we are trying to print outside the screen, return */
+	if (!str || y <= -DISPLAY_ROW_BITS || y >= DISPLAY_HEIGHT)
+		return;
+
+	const uint8_t *glyph;
+	uint32_t data, old_data, changed = 0;
+	int col, first = DISPLAY_WIDTH, last = 0;
+#if PROFILE
+	uint32_t start = cp0_get_count();
+	uint8_t glyphs = 0;
+#endif
+
+	/* Copy string to screen buffer, character by character */
+	for (; *str && x < DISPLAY_WIDTH; str++, x += 8)
+	{
+		/* Skip characters left of the screen */
+		if (x <= -8)
+			continue;
+#if PROFILE
+		glyphs++;
+#endif
+
+		glyph = &font[(*str & 0x7F) * 8];
+		for (col = 0; col < 8; col++)
+		{
+			/* Empty glyph columns, e.g. most of a space, change nothing */
+			if (!glyph[col] || x + col < 0 || x + col >= DISPLAY_WIDTH)
+				continue;
+
+			data = (y >= 0) ? (uint32_t)glyph[col] << y : (uint32_t)glyph[col] >> -y;
+			old_data = screen_data[x + col];
+			screen_data[x + col] |= data;
+
+			if (screen_data[x + col] != old_data)
+			{
+				changed |= screen_data[x + col] ^ old_data;
+				if (x + col < first)
+					first = x + col;
+				last = x + col;
+			}
+		}
+	}
+
+	if (changed)
+		display_mark_dirty_columns(first, last + 1, changed);
+#if PROFILE
+	/* Recorded per glyph, so strings of any length compare */
+	if (glyphs)
+		profile_record(PROFILE_TEXT, (cp0_get_count() - start) / glyphs);
+#endif
 }
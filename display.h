@@ -10,7 +10,11 @@
  * @author F. Lundevall
  * @author Alex Lindberg
 */
+#ifndef DISPLAY_HEADER
+#define DISPLAY_HEADER
+
 #include <stdint.h>
+#include <stdbool.h>
 #include <pic32mx.h> /* Declarations of system-specific addresses etc */
 
 /* --------------------------------------------- */
@@ -30,31 +34,232 @@
 /* Display controller commands */
 #define CMD_CHARGE_PHASE1(x) (uint8_t)(x)
 #define CMD_CHARGE_PHASE2(x) (uint8_t)(x << 4)
+#define CMD_SET_ADDRESSING_MODE (uint8_t)0x20
+#define CMD_SET_COLUMN_ADDRESS (uint8_t)0x21
 #define CMD_SET_PAGE_ADDRESS (uint8_t)0x22
+#define CMD_SET_PAGE_START(p) (uint8_t)(0xB0 | ((p) & 0x7))
+#define CMD_SET_COLUMN_LOW(x) (uint8_t)((x) & 0xF)
+#define CMD_SET_COLUMN_HIGH(x) (uint8_t)(0x10 | (((x) >> 4) & 0xF))
+#define CMD_SET_START_LINE(l) (uint8_t)(0x40 | ((l) & 0x3F))
+#define CMD_SCROLL_RIGHT (uint8_t)0x26
+#define CMD_SCROLL_LEFT (uint8_t)0x27
+#define CMD_SCROLL_STOP (uint8_t)0x2E
+#define CMD_SCROLL_START (uint8_t)0x2F
+
+/* Arguments of CMD_SET_ADDRESSING_MODE */
+#define ADDRESSING_HORIZONTAL 0x0
+#define ADDRESSING_PAGE 0x2
+
+/* SPI2 clock is PBCLK / (2 * (DISPLAY_SPI_BRG + 1)), 3 gives 10 MHz at
+   80 MHz which is the fastest serial clock the SSD1306 is specified for */
+#define DISPLAY_SPI_BRG 3
+
+/* SPI2 transmit interrupt, IRQ 38, bit 6 in IFS(1)/IEC(1) */
+#define DISPLAY_SPI2TX_IRQ (1 << 6)
+/* Priority of the SPI2 interrupts, vector 31. The highest, which gets the
+   shadow register set: the FIFO has to be refilled within 6.4 us */
+#define DISPLAY_SPI_PRIORITY 7
+
+/* Raster operations for display_blit() */
+#define BLIT_SET 0 /* OR the sprite onto the screen */
+#define BLIT_CLR 1 /* AND the screen with the inverted sprite */
+#define BLIT_XOR 2 /* XOR the sprite onto the screen, doing it twice erases it */
+
+/* Greyscale levels, the share of subframes a pixel is lit in */
+#define GREY_BLACK 0
+#define GREY_DARK 1
+#define GREY_LIGHT 2
+#define GREY_WHITE 3
+/* Subframes per greyscale frame, and how many a subframe is sent per
+   second. Each of the 3 shows one bitplane, the high plane twice. */
+#define DISPLAY_GREY_SUBFRAMES 3
+#define DISPLAY_GREY_SUBFRAME_RATE 360
+
+/* display_asset flags: the data is run-length coded, see host/pbm2asset.c */
+#define ASSET_RLE 0x1
+
+/* Widest sprite that display_blit() can draw */
+#define DISPLAY_SPRITE_MAX_WIDTH 32
 
 #define DISPLAY_WIDTH 128
 #define DISPLAY_HEIGHT 32
 #define DISPLAY_ROW_SETS 4
 #define DISPLAY_ROW_BITS 8
 
+/* The controller's memory holds twice the screen: 8 pages, 64 lines */
+#define DISPLAY_MEMORY_PAGES 8
+#define DISPLAY_MEMORY_LINES (DISPLAY_MEMORY_PAGES * DISPLAY_ROW_BITS)
+
 /* -------------------------------------------- */
 /* ---------------- From Lab 1 ---------------- */
 
 /* Declare display-related functions from mipslabfunc.c */
 void display_init(void);
+
+/* display_init_step() has nothing left to do */
+#define DISPLAY_INIT_DONE 0
+
+/**
+ * @brief       Does display_init() a step at a time, so other things can be
+ *              set up while the display powers up. The display is ready,
+ *              cleared like after display_init(), once it returns
+ *              DISPLAY_INIT_DONE.
+ * 
+ * @return      microseconds to wait before the next call, or
+ *              DISPLAY_INIT_DONE
+*/
+uint32_t display_init_step(void);
+
+/**
+ * @brief       Prints a string with the top left corner of the first
+ *              character at (x, y), 8x8 pixels per character. Stops at the
+ *              end of the string or of the screen, characters partly
+ *              outside of the screen are clipped. Pixels are only set,
+ *              never cleared.
+ * 
+ * @param s     the string to print
+ * @param x     left edge of the first character, may be negative
+ * @param y     top edge, may be negative
+*/
 void display_print_text(char *s, int x, int y);
-void display_image(int x, const uint8_t *data);
 void display_update(void);
 uint8_t spi_send_recv(uint8_t data);
-void quicksleep(int cyc);
 
 /* Declare text buffer for display output */
 extern char textbuffer[4][16];
 extern const uint8_t const font[128 * 8];
 
+/* --------------------------------------------- */
+/* ---------------- Structs -------------------- */
+
+/**
+ * @brief   A small 1-bpp image that can be drawn with display_blit().
+ *          Stored like the screen: bit y of columns[x] is pixel (x, y).
+ * @author  Alex Lindberg
+*/
+struct display_sprite
+{
+    uint8_t width, height;
+    uint32_t columns[DISPLAY_SPRITE_MAX_WIDTH];
+};
+
+/**
+ * @brief   A bitmap in the display's page format, made from an image by
+ *          host/pbm2asset: page by page, each page left to right, one
+ *          byte per column with the top row in bit 0.
+ * @author  Alex Lindberg
+*/
+struct display_asset
+{
+    uint8_t width;
+    uint8_t pages;          // Height in pages of 8 rows
+    uint8_t flags;          // ASSET_RLE if the data is run-length coded
+    uint16_t size;          // Bytes of data
+    const uint8_t *data;
+};
+
+/**
+ * @brief   Reads the bytes of an asset in order, expanding run-length
+ *          coded ones on the fly. See display_asset_open().
+ * @author  Alex Lindberg
+*/
+struct display_asset_reader
+{
+    const uint8_t *next;    // Next byte of the data
+    uint8_t count;          // Bytes left of the current block
+    bool repeat;            // Whether the current block repeats one byte
+    bool rle;
+};
+
+/**
+ * @brief   The parts of a frame that changed: columns [x0[j], x1[j]) of
+ *          every page j whose bit is set in pages.
+ * @author  Alex Lindberg
+*/
+struct display_window
+{
+    uint8_t pages;
+    uint8_t x0[DISPLAY_ROW_SETS];
+    uint8_t x1[DISPLAY_ROW_SETS];
+};
+
+/**
+ * @brief   Where frames are sent. The frame data is the screen data
+ *          buffer, one word per column with bit y being row y.
+ *          The functions returning uint16_t return the number of bytes
+ *          sent to the display.
+*/
+struct display_backend
+{
+    /* Powers up and configures the display */
+    void (*init)(void);
+    /* Sends the whole frame, blocking */
+    uint16_t (*flush)(const uint32_t *data);
+    /* Sends columns [x0, x1) of one page, blocking */
+    uint16_t (*flush_region)(const uint32_t *data, uint8_t page, uint8_t x0, uint8_t x1);
+    /* Starts sending the windows of a frame and returns, done() is called
+       when the last byte has been sent. May be NULL. */
+    uint16_t (*flush_async)(const uint32_t *data, const struct display_window *window,
+                            void (*done)(void));
+    /* Whether an asynchronous flush is running. May be NULL. */
+    bool (*busy)(void);
+    /* Memory page that page 0 of the frame is sent to. May be NULL. */
+    void (*set_page_base)(uint8_t page);
+    /* Memory line shown on the top row of the screen. May be NULL. */
+    void (*set_start_line)(uint8_t line);
+    /* Starts scrolling frame pages [page0, page1] sideways, right for a
+       positive direction and left for a negative, or stops it for 0.
+       interval is the controller's step interval code. May be NULL. */
+    void (*scroll)(int8_t direction, uint8_t page0, uint8_t page1, uint8_t interval);
+    /* Sends an asset straight from flash to columns [x, x + width) of
+       frame pages [page, page + pages), blocking. May be NULL. */
+    uint16_t (*stream)(const struct display_asset *asset, uint8_t x, uint8_t page);
+    /* Runs step number step, from 0, of what init() does and returns the
+       microseconds to wait before the next one, or DISPLAY_INIT_DONE after
+       the last. May be NULL, init() is used. */
+    uint32_t (*init_step)(uint8_t step);
+};
+
+/**
+ * @brief   What greyscale mode costs, counted since it was enabled.
+ *          Cycles are CP0 count ticks, see cp0.h.
+*/
+struct display_grey_stats
+{
+    uint32_t subframes;     // Subframes sent
+    uint32_t overruns;      // Ticks skipped as the last subframe was still being sent
+    uint32_t bytes;         // Bytes sent to the display
+    uint32_t tick_cycles;   // Spent in display_grey_tick()
+    uint32_t isr_cycles;    // Spent in display_spi_isr()
+    uint32_t elapsed;       // Count ticks since greyscale mode was enabled
+};
+
+/* The I/O board's OLED, see display_ssd1306.c */
+extern const struct display_backend display_ssd1306_backend;
+
+/**
+ * @brief       Changes the SPI2 clock of the OLED, see DISPLAY_SPI_BRG.
+ *              Waits for a running flush to finish first.
+ * 
+ * @param brg   new value of SPI2BRG
+*/
+void display_ssd1306_set_spi_brg(uint8_t brg);
+
+/* CP0 count ticks spent in display_spi_isr(), see cp0.h */
+extern volatile uint32_t display_spi_isr_cycles;
+
 /* --------------------------------------------- */
 /* ----------- Function declarations ----------- */
 
+/**
+ * @brief       Selects where frames are sent, e.g. a headless backend when
+ *              running on a PC. The default is display_ssd1306_backend.
+ *              Call before display_init().
+ * 
+ * @param backend   the backend to use
+*/
+void display_set_backend(const struct display_backend *backend);
+
 /**
  * @author      Alex Lindberg
  * @brief       Sets a pixel to either 1 or 0 depending on input 
@@ -97,7 +302,7 @@ void display_draw_filled_rect(int8_t x0, int8_t y0,
  * @param op 	which operation to perform, either SET or CLR.
  * 				SET sets the value to 1, CLR sets it to 0.
 */
-void display_horizontal_line(int8_t x0, int8_t x1, int8_t y, uint8_t op);
+void display_draw_horizontal_line(int8_t x0, int8_t x1, int8_t y, uint8_t op);
 
 /**
  * @author      Alex Lindberg
@@ -109,7 +314,7 @@ void display_horizontal_line(int8_t x0, int8_t x1, int8_t y, uint8_t op);
  * @param op 	which operation to perform, either SET or CLR.
  * 				SET sets the value to 1, CLR sets it to 0.
 */
-void display_vertical_line(int8_t y0, int8_t y1, int8_t x, uint8_t op);
+void display_draw_vertical_line(int8_t y0, int8_t y1, int8_t x, uint8_t op);
 
 /**
  * @author      Alex Lindberg
@@ -126,5 +331,326 @@ void display_vertical_line(int8_t y0, int8_t y1, int8_t x, uint8_t op);
 void display_draw_empty_rect(int8_t x0, int8_t y0,
                               int8_t x1, int8_t y1, uint8_t op);
 
+/**
+ * @brief       Creates a sprite from a bitmap in the display's page format,
+ *              i.e. one byte per column and 8 rows per byte, pages after
+ *              each other. This is the format of font[] and of assets.
+ * 
+ * @param sprite    the sprite to fill in
+ * @param data      the bitmap, width * ceil(height / 8) bytes
+ * @param width     width in pixels, only the first DISPLAY_SPRITE_MAX_WIDTH
+ *                  columns are used
+ * @param height    height in pixels, only the first 32 rows are used
+*/
+void display_sprite_from_pages(struct display_sprite *sprite, const uint8_t *data,
+                               uint8_t width, uint8_t height);
+
+/**
+ * @brief       Creates a solid rectangular sprite, e.g. a paddle or the ball.
+ * 
+ * @param sprite    the sprite to fill in
+ * @param width     width in pixels, at most DISPLAY_SPRITE_MAX_WIDTH
+ * @param height    height in pixels, at most 32
+*/
+void display_sprite_filled(struct display_sprite *sprite, uint8_t width, uint8_t height);
+
+/**
+ * @brief       Draws a sprite with its top left corner at (x, y). Parts
+ *              outside of the screen are clipped. Every column of the
+ *              sprite costs one shift and one raster operation.
+ * 
+ * @param sprite    the sprite to draw
+ * @param x         left edge, may be negative
+ * @param y         top edge, may be negative
+ * @param rop       BLIT_SET, BLIT_CLR or BLIT_XOR. Drawing a sprite twice
+ *                  with BLIT_XOR at the same position erases it.
+*/
+void display_blit(const struct display_sprite *sprite, int x, int y, uint8_t rop);
+
+/**
+ * @brief   Saves the current screen as the background layer. Build the
+ *          static parts of a screen (text, borders) once, save them, and
+ *          then move objects around by restoring their old footprint with
+ *          display_restore_background() before drawing them again.
+*/
+void display_save_background(void);
+
+/**
+ * @brief       Copies a rectangle of the background layer back onto the
+ *              screen, clipped to the screen.
+ * 
+ * @param x         left edge, may be negative
+ * @param y         top edge, may be negative
+ * @param width     width in pixels
+ * @param height    height in pixels
+*/
+void display_restore_background(int x, int y, int width, int height);
+
+/**
+ * @brief       Replaces the rows in mask of a run of screen columns, e.g.
+ *              a field of text that is redrawn every frame. Only columns
+ *              whose pixels actually change are marked for sending, so
+ *              drawing the same thing again costs nothing on the bus.
+ * 
+ * @param columns   the new columns, bit y is row y
+ * @param x         left edge, may be negative
+ * @param width     number of columns
+ * @param mask      rows to replace, the others are kept
+*/
+void display_put_columns(const uint32_t *columns, int x, int width, uint32_t mask);
+
+/**
+ * @brief   Starts sending the changed parts of the screen to the display
+ *          and returns without waiting for it to finish. The bytes are
+ *          sent by display_spi_isr() on SPI2 transmit interrupts.
+ * 
+ *          The screen is double buffered: the finished frame is sent from
+ *          one buffer while the drawing functions keep working on the
+ *          other, which starts out as a copy of the frame being sent.
+ *          If a previous flush is still running, this waits for it first.
+ *          Requires interrupts to be enabled.
+*/
+void display_update_async(void);
+
+/**
+ * @brief   Checks whether an asynchronous flush is still running.
+ * 
+ * @return  true until the last byte of the frame has been handed to SPI2
+*/
+bool display_update_busy(void);
+
+/**
+ * @brief   Waits for an asynchronous flush to finish.
+*/
+void display_update_wait(void);
+
+/**
+ * @brief   Sets a function to call when an asynchronous flush is done.
+ *          The callback normally runs in interrupt context, keep it short.
+ *          It is called directly when a flush has nothing to send.
+ * 
+ * @param callback  function to call, or NULL for none
+*/
+void display_set_flush_callback(void (*callback)(void));
+
+/**
+ * @brief   SPI2 transmit interrupt handler driving the asynchronous flush.
+ *          Should be called from the interrupt routine when the SPI2TX
+ *          flag is set.
+*/
+void display_spi_isr(void);
+
+/**
+ * @brief   Marks the whole screen as changed, forcing the next call to
+ *          display_update() to send every page. Needed whenever the
+ *          display's memory no longer matches the screen data buffer.
+*/
+void display_invalidate(void);
+
+/**
+ * @brief   When a page of the frame last reached the display: the CP0
+ *          Count at the end of the update that sent it. An asynchronous
+ *          update stamps all of its pages when the last byte has gone.
+ * 
+ * @param page      0-3
+*/
+uint32_t display_get_page_sent(uint8_t page);
+
+/**
+ * @brief   Retrieves the number of bytes, commands and pixel data, that
+ *          the last call to display_update() or display_update_async()
+ *          sent to the display.
+ *          Only pages and columns changed since the previous update are
+ *          sent, so this is a measure of how much of the frame changed.
+ * 
+ * @return  number of bytes sent over SPI by the last update
+*/
+uint16_t display_get_bytes_sent(void);
+
+/**
+ * @brief   Selects where in the controller's memory frames go: page 0 of
+ *          the screen is sent to memory page `page` and the rest follow,
+ *          wrapping around after page 7. What isn't shown can be drawn
+ *          this way and brought into view with the start line.
+ *          Marks the whole screen as changed if the base moved.
+ * 
+ * @param page      memory page, 0-7
+*/
+void display_set_page_base(uint8_t page);
+
+/**
+ * @return  the memory page that screen page 0 is sent to
+*/
+uint8_t display_get_page_base(void);
+
+/**
+ * @brief   Selects the memory line shown on the top row of the screen.
+ *          The screen shows 32 of the 64 lines in memory, wrapping around,
+ *          so moving the picture only costs one command byte.
+ * 
+ * @param line      memory line, 0-63
+*/
+void display_set_start_line(uint8_t line);
+
+/**
+ * @return  the memory line shown on the top row
+*/
+uint8_t display_get_start_line(void);
+
+/**
+ * @brief   Moves the start line up to `step` lines closer to target, for
+ *          scrolling smoothly with one call per frame.
+ * 
+ * @param target    memory line to end up on
+ * @param step      the most lines to move
+ * @return          true once the start line is at target
+*/
+bool display_move_start_line(uint8_t target, uint8_t step);
+
+/**
+ * @brief   Lets the controller scroll screen pages [page0, page1]
+ *          sideways by itself, wrapping around, without sending anything
+ *          more. The next update stops the scroll, since the memory must
+ *          not be written while scrolling.
+ * 
+ * @param left      true to scroll left, false for right
+ * @param page0     first page to scroll
+ * @param page1     last page to scroll
+ * @param interval  step interval code of the SSD1306, 7 is the fastest
+*/
+void display_scroll_horizontal(bool left, uint8_t page0, uint8_t page1, uint8_t interval);
+
+/**
+ * @brief   Stops a display_scroll_horizontal() and marks the screen as
+ *          changed, as the scroll has moved the memory under it.
+*/
+void display_scroll_stop(void);
+
+/* --------------------------------------------- */
+/* ------------------ Assets ------------------- */
+
+/**
+ * @brief   Starts reading the bytes of an asset.
+*/
+void display_asset_open(struct display_asset_reader *reader, const struct display_asset *asset);
+
+/**
+ * @brief   The next byte of an asset, in page order. Don't read more than
+ *          width * pages bytes.
+*/
+uint8_t display_asset_read(struct display_asset_reader *reader);
+
+/**
+ * @brief   Draws an asset into the screen data buffer in one pass, with
+ *          its top left corner at (x, y). Pixels in the asset's rectangle
+ *          are set to the asset, clipped to the screen.
+*/
+void display_draw_asset(const struct display_asset *asset, int x, int y);
+
+/**
+ * @brief   Sends an asset to the display without going through the screen
+ *          data buffer, decoding it straight into SPI2, e.g. a splash
+ *          screen. It stays on the display until the next update, which
+ *          sends the screen data buffer over it. The asset must fit in
+ *          the screen; it's drawn and sent the normal way if the backend
+ *          can't stream.
+ * 
+ * @param x         left column
+ * @param page      top page, 0-3
+ * @return          number of bytes sent, 0 if it doesn't fit
+*/
+uint16_t display_stream_asset(const struct display_asset *asset, uint8_t x, uint8_t page);
+
+/* --------------------------------------------- */
+/* ----------------- Greyscale ----------------- */
+
+/**
+ * @brief   Turns greyscale mode on or off. In greyscale mode every pixel
+ *          has 4 levels, made by lighting it in 0 to 3 of the 3 subframes
+ *          that display_grey_tick() sends in turn. display_update() and
+ *          display_update_async() do nothing while it's on, the screen
+ *          data buffer can still be drawn to and taken into the greyscale
+ *          picture with display_grey_draw_screen(). Turning it off sends
+ *          the screen data buffer again.
+ * 
+ * @param on    true to turn it on
+*/
+void display_grey_enable(bool on);
+
+/**
+ * @return  whether greyscale mode is on
+*/
+bool display_grey_enabled(void);
+
+/**
+ * @brief   Sends the next subframe. Call it DISPLAY_GREY_SUBFRAME_RATE
+ *          times a second from a timer interrupt; the subframes must be
+ *          shown equally long for the levels to come out right, so a
+ *          tick arriving while the last subframe is still being sent is
+ *          skipped and counted as an overrun.
+*/
+void display_grey_tick(void);
+
+/**
+ * @brief   Sets every pixel of the greyscale picture being drawn to
+ *          GREY_BLACK.
+*/
+void display_grey_clear(void);
+
+/**
+ * @brief   Sets a pixel of the greyscale picture being drawn.
+ * 
+ * @param x         column, 0-127
+ * @param y         row, 0-31
+ * @param level     GREY_BLACK to GREY_WHITE
+*/
+void display_grey_set_pixel(uint8_t x, uint8_t y, uint8_t level);
+
+/**
+ * @brief   Sets the pixels in the rectangle with the corners (x0, y0) and
+ *          (x1, y1), both included, clipped to the screen.
+ * 
+ * @param level     GREY_BLACK to GREY_WHITE
+*/
+void display_grey_fill_rect(int x0, int y0, int x1, int y1, uint8_t level);
+
+/**
+ * @brief   Sets the pixels that are set in the sprite, clipped to the
+ *          screen. The sprite's other pixels are left as they are.
+ * 
+ * @param level     GREY_BLACK to GREY_WHITE
+*/
+void display_grey_blit(const struct display_sprite *sprite, int x, int y, uint8_t level);
+
+/**
+ * @brief   Sets the pixels that are lit in the screen data buffer, so
+ *          that anything drawn with the normal drawing functions can be
+ *          used at one of the levels.
+ * 
+ * @param level     GREY_BLACK to GREY_WHITE
+*/
+void display_grey_draw_screen(uint8_t level);
+
+/**
+ * @brief   Hands the picture that has been drawn over to display_grey_tick(),
+ *          which starts showing it with the next greyscale frame.
+ *          Don't draw again before display_grey_presenting() returns
+ *          false; after that the next picture is drawn on top of the one
+ *          presented before this one.
+*/
+void display_grey_present(void);
+
+/**
+ * @return  true until a presented picture is being shown
+*/
+bool display_grey_presenting(void);
+
+/**
+ * @brief   Retrieves what greyscale mode has cost so far.
+*/
+void display_grey_get_stats(struct display_grey_stats *stats);
+
 //char * itoaconv( int num );
-//void concat_strings(char *s1, char *s2);
\ No newline at end of file
+//void concat_strings(char *s1, char *s2);
+
+#endif /* DISPLAY_HEADER */
@@ -0,0 +1,524 @@
+/** 
+ * display_ssd1306.c
+ * Display backend for the I/O board's OLED, an SSD1306 controller
+ * connected to SPI2.
+ * 
+ * Large parts of this code is written 2015 by F. Lundevall
+ * Some parts are original code written by Axel Isaksson
+ * 
+ * @author Axel Isaksson
+ * @author F. Lundevall
+ * @author Alex Lindberg
+*/
+#include "display.h"
+#include "cp0.h"
+#include <string.h>
+
+/* --------------------------------------------- */
+/* ---------------- Definitions ---------------- */
+
+/* SPI2STAT bits, with ENHBUF set the buffer bits refer to the FIFOs */
+#define SPI_RX_FULL 0x01
+#define SPI_TX_FULL 0x02
+#define SPI_TX_EMPTY 0x08
+#define SPI_RX_EMPTY 0x20
+#define SPI_OVERFLOW 0x40
+#define SPI_SHIFT_EMPTY 0x80
+
+/* SPI2CON bits */
+#define SPI_ON 0x8000
+/* STXISEL, when the transmit interrupt is raised */
+#define SPI_TX_IRQ_MASK 0xC
+#define SPI_TX_IRQ_SHIFTED_OUT 0x0	/* the last byte has been shifted out */
+#define SPI_TX_IRQ_HALF_EMPTY 0x8	/* the FIFO is at least half empty */
+
+/* States of the interrupt driven flush */
+#define FLUSH_IDLE 0
+#define FLUSH_COMMAND 1
+#define FLUSH_TO_DATA 2
+#define FLUSH_DATA 3
+#define FLUSH_TO_COMMAND 4
+
+/* Number of command bytes sent in front of every window: the column and
+   page address commands with their arguments */
+#define FLUSH_COMMAND_BYTES 6
+
+/* Extra cost in bytes of sending a window instead of merging it into
+   another one, for the wait for the bus to empty when the D/C line changes */
+#define FLUSH_SWITCH_COST 2
+
+/* Power-up waits in microseconds: for VDD to settle, the reset pulse
+   (at least 3 us) and for VBAT to settle before the display is turned on */
+#define SSD1306_VDD_US 1000
+#define SSD1306_RESET_US 3
+#define SSD1306_VBAT_US 100000
+
+/* --------------------------------------------- */
+/* -------------- Local variables -------------- */
+
+/* A block of columns [x0, x1) in pages [page0, page1] that is sent in one
+   data phase. With horizontal addressing the controller takes the bytes
+   page by page, each page from left to right. */
+struct flush_burst
+{
+	uint8_t x0, x1;
+	uint8_t page0, page1;
+};
+
+/* State of the interrupt driven flush, shared with display_spi_isr() */
+static volatile uint8_t flush_state = FLUSH_IDLE;
+static const uint32_t *flush_data;
+static struct flush_burst flush_bursts[DISPLAY_ROW_SETS];
+static uint8_t flush_burst_count;
+static uint8_t flush_burst;
+static uint8_t flush_page;
+static uint8_t flush_column;
+static uint8_t flush_command[FLUSH_COMMAND_BYTES];
+static void (*flush_done)(void);
+
+volatile uint32_t display_spi_isr_cycles;
+
+/* Memory page that page 0 of the frame goes to */
+static uint8_t page_base;
+
+/* --------------------------------------------- */
+/* -------------- Local functions -------------- */
+
+static void ssd1306_init(void);
+static uint32_t ssd1306_init_step(uint8_t step);
+static uint16_t ssd1306_flush(const uint32_t *data);
+static uint16_t ssd1306_flush_region(const uint32_t *data, uint8_t page, uint8_t x0, uint8_t x1);
+static uint16_t ssd1306_flush_async(const uint32_t *data, const struct display_window *window, void (*done)(void));
+static bool ssd1306_busy(void);
+static void ssd1306_set_page_base(uint8_t page);
+static void ssd1306_set_start_line(uint8_t line);
+static void ssd1306_scroll(int8_t direction, uint8_t page0, uint8_t page1, uint8_t interval);
+static uint16_t ssd1306_stream(const struct display_asset *asset, uint8_t x, uint8_t page);
+
+/* Sends command bytes, blocking */
+static void ssd1306_command(const uint8_t *command, uint8_t count);
+/* Queues a byte, waiting only for room in the transmit FIFO */
+static void spi_send(uint8_t data);
+/* Waits until every queued byte has been shifted out and throws away what
+   was received meanwhile */
+static void spi_wait_idle(void);
+/* Sends one burst: its window commands, then its bytes in one data phase */
+static uint16_t ssd1306_send_burst(const uint32_t *data, const struct flush_burst *burst);
+/* Fills the command bytes that select the window of a burst */
+static void ssd1306_window_commands(uint8_t command[FLUSH_COMMAND_BYTES], const struct flush_burst *burst);
+/* Splits the dirty windows into as few bytes on the bus as possible */
+static uint8_t ssd1306_plan_bursts(const struct display_window *window, struct flush_burst bursts[DISPLAY_ROW_SETS]);
+/* Moves on to the command phase of the next burst */
+static void ssd1306_flush_next_burst(void);
+/* The SPI2 interrupt handler, see display_spi_isr() */
+static void ssd1306_isr(void);
+
+/* ---------------------------------------------- */
+/* ------------------- Backend ------------------- */
+
+const struct display_backend display_ssd1306_backend = {
+	ssd1306_init,
+	ssd1306_flush,
+	ssd1306_flush_region,
+	ssd1306_flush_async,
+	ssd1306_busy,
+	ssd1306_set_page_base,
+	ssd1306_set_start_line,
+	ssd1306_scroll,
+	ssd1306_stream,
+	ssd1306_init_step,
+};
+
+/* ---------------------------------------------- */
+/* ------------ Function definitions ------------ */
+
+uint8_t spi_send_recv(uint8_t data)
+{
+	/* Throw away what the transmit-only sends left in the receive FIFO */
+	spi_wait_idle();
+	SPI2BUF = data;
+	while (SPI2STAT & SPI_RX_EMPTY)
+		;
+	return SPI2BUF;
+}
+
+void display_ssd1306_set_spi_brg(uint8_t brg)
+{
+	while (flush_state != FLUSH_IDLE)
+		;
+	spi_wait_idle();
+
+	/* The baud rate may only be changed while the module is off */
+	SPI2CONCLR = SPI_ON;
+	SPI2BRG = brg;
+	SPI2CONSET = SPI_ON;
+}
+
+static void spi_send(uint8_t data)
+{
+	while (SPI2STAT & SPI_TX_FULL)
+		;
+	SPI2BUF = data;
+}
+
+static void spi_wait_idle(void)
+{
+	while ((SPI2STAT & (SPI_TX_EMPTY | SPI_SHIFT_EMPTY)) != (SPI_TX_EMPTY | SPI_SHIFT_EMPTY))
+		;
+	while (!(SPI2STAT & SPI_RX_EMPTY))
+		(void)SPI2BUF;
+	SPI2STATCLR = SPI_OVERFLOW;
+}
+
+static void ssd1306_init(void)
+{
+	uint8_t step = 0;
+	uint32_t wait;
+
+	while ((wait = ssd1306_init_step(step++)) != DISPLAY_INIT_DONE)
+		cp0_delay_us(wait);
+}
+
+/*
+	The power-up sequence of the SSD1306 datasheet and the Basic I/O
+	Shield's reference manual, with the waits left to the caller.
+*/
+static uint32_t ssd1306_init_step(uint8_t step)
+{
+	switch (step)
+	{
+	case 0:
+		/* Apply power to display controller (VDD) */
+		DISPLAY_CHANGE_TO_COMMAND_MODE;
+		DISPLAY_ACTIVATE_VDD;
+		return SSD1306_VDD_US;
+
+	case 1:
+		/* Turn off display */
+		spi_send_recv(0xAE);
+		DISPLAY_ACTIVATE_RESET;
+		return SSD1306_RESET_US;
+
+	case 2:
+		DISPLAY_DO_NOT_RESET;
+		return SSD1306_RESET_US;
+
+	case 3:
+		/* Enable 7.5 V to display */
+		spi_send_recv(0x8D);
+		spi_send_recv(0x14);
+		spi_send_recv(0xD9);
+		spi_send_recv(CMD_CHARGE_PHASE1(1) | CMD_CHARGE_PHASE2(15));
+
+		/* Apply power display (VBAT) */
+		DISPLAY_ACTIVATE_VBAT;
+		return SSD1306_VBAT_US;
+
+	default:
+		/* Set COM output and scan direction */
+		spi_send_recv(0xA1);
+		spi_send_recv(0xC8);
+
+		/* Set COM pins */
+		spi_send_recv(0xDA);
+		spi_send_recv(0x20);
+
+		/* Horizontal addressing, the write pointer runs through a whole window
+		   by itself so a frame is sent in one go */
+		spi_send_recv(CMD_SET_ADDRESSING_MODE);
+		spi_send_recv(ADDRESSING_HORIZONTAL);
+
+		/* Turn on display */
+		spi_send_recv(0xAF);
+		return DISPLAY_INIT_DONE;
+	}
+}
+
+static uint16_t ssd1306_flush(const uint32_t *data)
+{
+	struct flush_burst burst = {0, DISPLAY_WIDTH, 0, DISPLAY_ROW_SETS - 1};
+	return ssd1306_send_burst(data, &burst);
+}
+
+static uint16_t ssd1306_flush_region(const uint32_t *data, uint8_t page, uint8_t x0, uint8_t x1)
+{
+	struct flush_burst burst = {x0, x1, page, page};
+	return ssd1306_send_burst(data, &burst);
+}
+
+static uint16_t ssd1306_send_burst(const uint32_t *data, const struct flush_burst *burst)
+{
+	uint8_t command[FLUSH_COMMAND_BYTES];
+	uint8_t i, j;
+
+	/* The D/C line may only change when the bus is idle */
+	spi_wait_idle();
+	DISPLAY_CHANGE_TO_COMMAND_MODE;
+	ssd1306_window_commands(command, burst);
+	for (i = 0; i < FLUSH_COMMAND_BYTES; i++)
+		spi_send(command[i]);
+
+	spi_wait_idle();
+	DISPLAY_CHANGE_TO_DATA_MODE;
+	for (j = burst->page0; j <= burst->page1; j++)
+	{
+		for (i = burst->x0; i < burst->x1; i++)
+			spi_send(data[i] >> (DISPLAY_ROW_BITS * j));
+	}
+	/* The last bytes are still shifting out, the next send waits for them */
+	return FLUSH_COMMAND_BYTES + (burst->x1 - burst->x0) * (burst->page1 - burst->page0 + 1);
+}
+
+static void ssd1306_window_commands(uint8_t command[FLUSH_COMMAND_BYTES], const struct flush_burst *burst)
+{
+	command[0] = CMD_SET_COLUMN_ADDRESS;
+	command[1] = burst->x0;
+	command[2] = burst->x1 - 1;
+	command[3] = CMD_SET_PAGE_ADDRESS;
+	command[4] = (burst->page0 + page_base) & (DISPLAY_MEMORY_PAGES - 1);
+	command[5] = (burst->page1 + page_base) & (DISPLAY_MEMORY_PAGES - 1);
+}
+
+static uint8_t ssd1306_plan_bursts(const struct display_window *window, struct flush_burst bursts[DISPLAY_ROW_SETS])
+{
+	struct flush_burst plan[DISPLAY_ROW_SETS];
+	struct flush_burst *b;
+	uint8_t pages[DISPLAY_ROW_SETS];
+	uint8_t dirty = 0, count, best_count = 0;
+	uint8_t splits, j, k;
+	uint16_t cost, best_cost = 0xFFFF;
+
+	for (j = 0; j < DISPLAY_ROW_SETS; j++)
+	{
+		if ((window->pages & (1 << j)) && window->x1[j] > window->x0[j])
+			pages[dirty++] = j;
+	}
+	if (!dirty)
+		return 0;
+
+	/* Try every way of grouping neighbouring dirty pages into bursts, bit k
+	   of splits starting a new burst at dirty page k + 1. A burst covers
+	   the columns and pages between its dirty windows, so merging sends
+	   some clean bytes but saves the window commands and a D/C switch. */
+	for (splits = 0; splits < (1 << (dirty - 1)); splits++)
+	{
+		count = 0;
+		for (k = 0; k < dirty; k++)
+		{
+			j = pages[k];
+			if (k == 0 || (splits & (1 << (k - 1))))
+			{
+				b = &plan[count++];
+				b->x0 = window->x0[j];
+				b->x1 = window->x1[j];
+				b->page0 = j;
+			}
+			else
+			{
+				if (window->x0[j] < b->x0)
+					b->x0 = window->x0[j];
+				if (window->x1[j] > b->x1)
+					b->x1 = window->x1[j];
+			}
+			b->page1 = j;
+		}
+
+		cost = 0;
+		for (k = 0; k < count; k++)
+			cost += FLUSH_COMMAND_BYTES + FLUSH_SWITCH_COST +
+					(plan[k].x1 - plan[k].x0) * (plan[k].page1 - plan[k].page0 + 1);
+		if (cost < best_cost)
+		{
+			best_cost = cost;
+			best_count = count;
+			memcpy(bursts, plan, count * sizeof(plan[0]));
+		}
+	}
+	return best_count;
+}
+
+static uint16_t ssd1306_flush_async(const uint32_t *data, const struct display_window *window, void (*done)(void))
+{
+	uint16_t bytes = 0;
+	uint8_t k;
+
+	flush_burst_count = ssd1306_plan_bursts(window, flush_bursts);
+	for (k = 0; k < flush_burst_count; k++)
+		bytes += FLUSH_COMMAND_BYTES + (flush_bursts[k].x1 - flush_bursts[k].x0) *
+										   (flush_bursts[k].page1 - flush_bursts[k].page0 + 1);
+	if (!flush_burst_count)
+	{
+		if (done)
+			done();
+		return 0;
+	}
+
+	flush_data = data;
+	flush_done = done;
+	flush_burst = 0;
+
+	/* The last bytes of a blocking update may still be shifting out */
+	spi_wait_idle();
+	DISPLAY_CHANGE_TO_COMMAND_MODE;
+	ssd1306_flush_next_burst();
+
+	/* The transmit FIFO is already empty, so set the interrupt flag by hand
+	   to start */
+	IPCCLR(7) = 0x7 << 26;
+	IPCSET(7) = DISPLAY_SPI_PRIORITY << 26;
+	IECSET(1) = DISPLAY_SPI2TX_IRQ;
+	IFSSET(1) = DISPLAY_SPI2TX_IRQ;
+	return bytes;
+}
+
+static bool ssd1306_busy(void)
+{
+	return flush_state != FLUSH_IDLE;
+}
+
+static void ssd1306_command(const uint8_t *command, uint8_t count)
+{
+	uint8_t i;
+
+	spi_wait_idle();
+	DISPLAY_CHANGE_TO_COMMAND_MODE;
+	for (i = 0; i < count; i++)
+		spi_send(command[i]);
+}
+
+static void ssd1306_set_page_base(uint8_t page)
+{
+	page_base = page;
+}
+
+static void ssd1306_set_start_line(uint8_t line)
+{
+	uint8_t command = CMD_SET_START_LINE(line);
+	ssd1306_command(&command, 1);
+}
+
+static void ssd1306_scroll(int8_t direction, uint8_t page0, uint8_t page1, uint8_t interval)
+{
+	uint8_t command[] = {
+		CMD_SCROLL_STOP,
+		direction > 0 ? CMD_SCROLL_RIGHT : CMD_SCROLL_LEFT,
+		0x00,
+		(page0 + page_base) & (DISPLAY_MEMORY_PAGES - 1),
+		interval & 0x7,
+		(page1 + page_base) & (DISPLAY_MEMORY_PAGES - 1),
+		0x00,
+		0xFF,
+		CMD_SCROLL_START,
+	};
+
+	/* A scroll must be stopped before it is set up again */
+	ssd1306_command(command, direction ? sizeof(command) : 1);
+}
+
+static void ssd1306_flush_next_burst(void)
+{
+	ssd1306_window_commands(flush_command, &flush_bursts[flush_burst]);
+	flush_column = 0;
+	flush_state = FLUSH_COMMAND;
+	SPI2CONCLR = SPI_TX_IRQ_MASK;
+	SPI2CONSET = SPI_TX_IRQ_HALF_EMPTY;
+}
+
+/*
+	The FIFO holds 16 bytes and the interrupt is raised when it is half
+	empty, so every interrupt queues up to 16 bytes. Before the D/C line
+	changes the interrupt is switched to fire once the last byte has been
+	shifted out. The bytes received meanwhile are never read, the receive
+	FIFO overflows and spi_wait_idle() clears it before the next flush.
+*/
+void display_spi_isr(void)
+{
+	uint32_t start = cp0_get_count();
+	ssd1306_isr();
+	display_spi_isr_cycles += cp0_get_count() - start;
+}
+
+static void ssd1306_isr(void)
+{
+	const struct flush_burst *burst = &flush_bursts[flush_burst];
+
+	IFSCLR(1) = DISPLAY_SPI2TX_IRQ;
+
+	switch (flush_state)
+	{
+	case FLUSH_TO_COMMAND:
+		DISPLAY_CHANGE_TO_COMMAND_MODE;
+		ssd1306_flush_next_burst();
+		/* fall through */
+	case FLUSH_COMMAND:
+		while (flush_column < FLUSH_COMMAND_BYTES)
+		{
+			if (SPI2STAT & SPI_TX_FULL)
+				return;
+			SPI2BUF = flush_command[flush_column++];
+		}
+		SPI2CONCLR = SPI_TX_IRQ_MASK;
+		SPI2CONSET = SPI_TX_IRQ_SHIFTED_OUT;
+		flush_state = FLUSH_TO_DATA;
+		break;
+	case FLUSH_TO_DATA:
+		DISPLAY_CHANGE_TO_DATA_MODE;
+		SPI2CONCLR = SPI_TX_IRQ_MASK;
+		SPI2CONSET = SPI_TX_IRQ_HALF_EMPTY;
+		flush_state = FLUSH_DATA;
+		flush_page = burst->page0;
+		flush_column = burst->x0;
+		/* fall through */
+	case FLUSH_DATA:
+		while (flush_page <= burst->page1)
+		{
+			if (SPI2STAT & SPI_TX_FULL)
+				return;
+			SPI2BUF = (uint8_t)(flush_data[flush_column] >> (DISPLAY_ROW_BITS * flush_page));
+			if (++flush_column == burst->x1)
+			{
+				flush_column = burst->x0;
+				flush_page++;
+			}
+		}
+
+		/* Every byte of the burst is queued */
+		if (++flush_burst < flush_burst_count)
+		{
+			SPI2CONCLR = SPI_TX_IRQ_MASK;
+			SPI2CONSET = SPI_TX_IRQ_SHIFTED_OUT;
+			flush_state = FLUSH_TO_COMMAND;
+			break;
+		}
+		flush_state = FLUSH_IDLE;
+		IECCLR(1) = DISPLAY_SPI2TX_IRQ;
+		if (flush_done)
+			flush_done();
+		break;
+	default:
+		IECCLR(1) = DISPLAY_SPI2TX_IRQ;
+		break;
+	}
+}
+
+static uint16_t ssd1306_stream(const struct display_asset *asset, uint8_t x, uint8_t page)
+{
+	struct flush_burst burst = {x, x + asset->width, page, page + asset->pages - 1};
+	struct display_asset_reader reader;
+	uint8_t command[FLUSH_COMMAND_BYTES];
+	uint16_t i, bytes = asset->width * asset->pages;
+
+	spi_wait_idle();
+	DISPLAY_CHANGE_TO_COMMAND_MODE;
+	ssd1306_window_commands(command, &burst);
+	for (i = 0; i < FLUSH_COMMAND_BYTES; i++)
+		spi_send(command[i]);
+
+	/* Assets are stored in the order horizontal addressing takes them */
+	spi_wait_idle();
+	DISPLAY_CHANGE_TO_DATA_MODE;
+	display_asset_open(&reader, asset);
+	for (i = 0; i < bytes; i++)
+		spi_send(display_asset_read(&reader));
+	return FLUSH_COMMAND_BYTES + bytes;
+}
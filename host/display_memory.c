@@ -0,0 +1,117 @@
+/**
+ * host/display_memory.c
+ * A display backend that keeps frames in memory.
+*/
+#include <string.h>
+#include "display_memory.h"
+
+/* --------------------------------------------- */
+/* -------------- Local variables -------------- */
+
+static uint8_t pages[DISPLAY_MEMORY_PAGES][DISPLAY_WIDTH];
+static uint8_t page_base;
+static uint8_t start_line;
+
+/* --------------------------------------------- */
+/* -------------- Local functions -------------- */
+
+static void memory_init(void);
+static uint16_t memory_flush(const uint32_t *data);
+static uint16_t memory_flush_region(const uint32_t *data, uint8_t page, uint8_t x0, uint8_t x1);
+static void memory_set_page_base(uint8_t page);
+static void memory_set_start_line(uint8_t line);
+static uint16_t memory_stream(const struct display_asset *asset, uint8_t x, uint8_t page);
+
+/* ---------------------------------------------- */
+/* ------------ Function definitions ------------ */
+
+/* No flush_async, display_update_async() falls back on blocking flushes,
+   and no hardware scrolling */
+const struct display_backend display_memory_backend = {
+    memory_init,
+    memory_flush,
+    memory_flush_region,
+    NULL,
+    NULL,
+    memory_set_page_base,
+    memory_set_start_line,
+    NULL,
+    memory_stream,
+    NULL,
+};
+
+static void memory_init(void)
+{
+    memset(pages, 0, sizeof(pages));
+    page_base = 0;
+    start_line = 0;
+}
+
+static uint16_t memory_flush(const uint32_t *data)
+{
+    uint16_t sent = 0;
+    uint8_t page;
+
+    for (page = 0; page < DISPLAY_ROW_SETS; page++)
+        sent += memory_flush_region(data, page, 0, DISPLAY_WIDTH);
+    return sent;
+}
+
+static uint16_t memory_flush_region(const uint32_t *data, uint8_t page, uint8_t x0, uint8_t x1)
+{
+    uint8_t x;
+
+    uint8_t *memory = pages[(page + page_base) % DISPLAY_MEMORY_PAGES];
+
+    for (x = x0; x < x1; x++)
+        memory[x] = data[x] >> (8 * page);
+    // Same count as the SSD1306: the window commands, then the data
+    return 6 + (x1 - x0);
+}
+
+static void memory_set_page_base(uint8_t page)
+{
+    page_base = page;
+}
+
+static void memory_set_start_line(uint8_t line)
+{
+    start_line = line;
+}
+
+static uint16_t memory_stream(const struct display_asset *asset, uint8_t x, uint8_t page)
+{
+    struct display_asset_reader reader;
+    uint8_t i, j;
+
+    display_asset_open(&reader, asset);
+    for (j = 0; j < asset->pages; j++)
+        for (i = 0; i < asset->width; i++)
+            pages[(page + j + page_base) % DISPLAY_MEMORY_PAGES][x + i] = display_asset_read(&reader);
+    return 6 + asset->width * asset->pages;
+}
+
+const uint8_t (*display_memory_pages(void))[DISPLAY_WIDTH]
+{
+    return (const uint8_t (*)[DISPLAY_WIDTH])pages;
+}
+
+int display_memory_write_pbm(FILE *f)
+{
+    uint8_t row[DISPLAY_WIDTH / 8];
+    int x, y, line;
+
+    fprintf(f, "P4\n%d %d\n", DISPLAY_WIDTH, DISPLAY_HEIGHT);
+    for (y = 0; y < DISPLAY_HEIGHT; y++)
+    {
+        memset(row, 0, sizeof(row));
+        line = (y + start_line) % DISPLAY_MEMORY_LINES;
+        // PBM rows are packed MSB first, 1 is black
+        for (x = 0; x < DISPLAY_WIDTH; x++)
+            if (pages[line / 8][x] & (1 << (line % 8)))
+                row[x / 8] |= 0x80 >> (x % 8);
+        if (fwrite(row, 1, sizeof(row), f) != sizeof(row))
+            return -1;
+    }
+    return 0;
+}
@@ -0,0 +1,36 @@
+/**
+ * host/display_memory.h
+ * A display backend that keeps frames in memory instead of sending them
+ * to the OLED, so that the game can be run and looked at on a PC.
+*/
+#ifndef HOST_DISPLAY_MEMORY_HEADER
+#define HOST_DISPLAY_MEMORY_HEADER
+
+#include <stdio.h>
+#include "display.h"
+
+/* --------------------------------------------- */
+/* ---------------- Definitions ---------------- */
+
+extern const struct display_backend display_memory_backend;
+
+/* --------------------------------------------- */
+/* ----------- Function declarations ----------- */
+
+/**
+ * @brief   The memory display's DISPLAY_MEMORY_PAGES pages, laid out like
+ *          the OLED's memory: byte [page][x] holds lines 8*page to
+ *          8*page + 7 of column x, lowest line in bit 0.
+*/
+const uint8_t (*display_memory_pages(void))[DISPLAY_WIDTH];
+
+/**
+ * @brief   Writes what the screen would show, the 32 lines from the start
+ *          line on, as a binary PBM (P4) image.
+ * 
+ * @param f         file to write to
+ * @return          0, or -1 if writing failed
+*/
+int display_memory_write_pbm(FILE *f);
+
+#endif /* HOST_DISPLAY_MEMORY_HEADER */
@@ -0,0 +1,204 @@
+/**
+ * host/greysim.c
+ * Runs the greyscale mode against the SSD1306 controller model and checks
+ * that the panel lights every pixel in as many subframes as its level.
+ * The pictures are drawn both with the display_grey_* functions and into
+ * a plain array of levels, which is what the panel is compared with.
+ * Prints what the subframes cost.
+ * 
+ *      host/greysim [-n greyscale frames] [-d dump interval] [-o dump directory]
+ * 
+ * Dumps are PGM images of the levels the panel showed.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "main.h"
+#include "cp0.h"
+#include "ssd1306_emu.h"
+
+/* --------------------------------------------- */
+/* ---------------- Definitions ---------------- */
+
+#define DEFAULT_FRAMES 600
+/* Interrupts allowed per subframe before giving up on a flush */
+#define MAX_ISR_CALLS 100000
+/* Length of the ball's trail */
+#define TRAIL 3
+
+/* --------------------------------------------- */
+/* -------------- Local variables -------------- */
+
+/* The picture as levels, [y][x] */
+static uint8_t model[DISPLAY_HEIGHT][DISPLAY_WIDTH];
+/* Subframes every pixel of the panel was lit in during the last frame */
+static uint8_t lit[DISPLAY_HEIGHT][DISPLAY_WIDTH];
+
+/* --------------------------------------------- */
+/* -------------- Local functions -------------- */
+
+/* Fills a rectangle in both the greyscale picture and the model */
+static void fill_rect(int x0, int y0, int x1, int y1, uint8_t level);
+/* Draws greyscale frame n: bars of every level and a ball with a fading trail */
+static void draw_picture(int n);
+/* Number of pixels where the panel doesn't match the model */
+static int compare(void);
+/* Writes what the panel showed as dir/grey_NNNNN.pgm */
+static void dump_frame(const char *dir, int frame);
+
+/* ---------------------------------------------- */
+/* ------------ Function definitions ------------ */
+
+int main(int argc, char **argv)
+{
+    int frames = DEFAULT_FRAMES;
+    int dump_interval = 0;
+    const char *dump_dir = ".";
+    struct display_grey_stats stats;
+    uint32_t isr_calls = 0;
+    int wrong_frames = 0;
+    int i, s, x, y, opt;
+
+    while ((opt = getopt(argc, argv, "n:d:o:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n':
+            frames = atoi(optarg);
+            break;
+        case 'd':
+            dump_interval = atoi(optarg);
+            break;
+        case 'o':
+            dump_dir = optarg;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-n frames] [-d dump interval] [-o dump directory]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    // SPI2 like initialize_system() sets it up
+    SPI2BRG = DISPLAY_SPI_BRG;
+    SPI2CON = 0x10000 | 0x8000 | 0x40 | 0x20;
+    ssd1306_emu_attach();
+    display_init();
+    display_grey_enable(true);
+
+    for (i = 0; i < frames; i++)
+    {
+        draw_picture(i);
+        display_grey_present();
+
+        // The timer ticks of one greyscale frame
+        memset(lit, 0, sizeof(lit));
+        for (s = 0; s < DISPLAY_GREY_SUBFRAMES; s++)
+        {
+            display_grey_tick();
+            isr_calls += host_run_interrupts(display_spi_isr, MAX_ISR_CALLS);
+            host_sfr_sync();
+            for (y = 0; y < DISPLAY_HEIGHT; y++)
+                for (x = 0; x < DISPLAY_WIDTH; x++)
+                    lit[y][x] += ssd1306_emu_pixel(x, y);
+        }
+
+        if (display_grey_presenting() || compare())
+        {
+            if (!wrong_frames)
+                fprintf(stderr, "frame %d: the panel doesn't show the picture\n", i);
+            wrong_frames++;
+        }
+        if (dump_interval > 0 && i % dump_interval == 0)
+            dump_frame(dump_dir, i);
+    }
+
+    display_grey_get_stats(&stats);
+    if (stats.subframes)
+    {
+        double spi_hz = 80e6 / (2 * (DISPLAY_SPI_BRG + 1));
+        double subframe_us = 1e6 / DISPLAY_GREY_SUBFRAME_RATE;
+        double bytes = (double)stats.bytes / stats.subframes;
+
+        printf("greyscale frames    %d, %u subframes, %u overruns\n", frames, stats.subframes, stats.overruns);
+        printf("bytes               %.1f /subframe\n", bytes);
+        // Here a byte is shifted out as soon as it's written, on the board
+        // the interrupt refills the FIFO every 8 bytes
+        printf("SPI interrupts      %.1f /subframe here, about %.0f on the board\n",
+               (double)isr_calls / stats.subframes, bytes / 8);
+        printf("SPI2 busy           %.1f us of %.1f us per subframe (%.1f%%) at %.1f MHz\n",
+               bytes * 8 / spi_hz * 1e6, subframe_us, bytes * 8 / spi_hz * 1e6 / subframe_us * 100, spi_hz / 1e6);
+        printf("CPU                 %.2f us tick + %.2f us SPI interrupts /subframe here\n",
+               (double)stats.tick_cycles / stats.subframes / CP0_TICKS_PER_US,
+               (double)stats.isr_cycles / stats.subframes / CP0_TICKS_PER_US);
+        printf("wrong frames        %d\n", wrong_frames);
+    }
+    return wrong_frames || ssd1306_emu_totals()->errors ? 2 : 0;
+}
+
+static void fill_rect(int x0, int y0, int x1, int y1, uint8_t level)
+{
+    int x, y;
+
+    display_grey_fill_rect(x0, y0, x1, y1, level);
+    for (y = y0 < 0 ? 0 : y0; y <= y1 && y < DISPLAY_HEIGHT; y++)
+        for (x = x0 < 0 ? 0 : x0; x <= x1 && x < DISPLAY_WIDTH; x++)
+            model[y][x] = level;
+}
+
+static void draw_picture(int n)
+{
+    int level, k, bx, by;
+
+    display_grey_clear();
+    memset(model, 0, sizeof(model));
+
+    // Bars of every level at the sides
+    for (level = GREY_BLACK; level <= GREY_WHITE; level++)
+    {
+        fill_rect(level * 4, 0, level * 4 + 3, DISPLAY_HEIGHT - 1, level);
+        fill_rect(DISPLAY_WIDTH - 4 - level * 4, 0, DISPLAY_WIDTH - 1 - level * 4, DISPLAY_HEIGHT - 1, level);
+    }
+    // A dimmed playfield border
+    fill_rect(16, 0, 111, 0, GREY_DARK);
+    fill_rect(16, DISPLAY_HEIGHT - 1, 111, DISPLAY_HEIGHT - 1, GREY_DARK);
+
+    // The ball bounces around, leaving a trail that fades out
+    for (k = TRAIL; k >= 0; k--)
+    {
+        bx = 20 + abs((n - k) * 3 % 168 - 84);
+        by = 2 + abs((n - k) % 52 - 26);
+        fill_rect(bx, by, bx + 1, by + 1, GREY_WHITE - (k * GREY_WHITE + TRAIL - 1) / TRAIL);
+    }
+}
+
+static int compare(void)
+{
+    int differences = 0;
+    int x, y;
+
+    for (y = 0; y < DISPLAY_HEIGHT; y++)
+        for (x = 0; x < DISPLAY_WIDTH; x++)
+            differences += lit[y][x] != model[y][x];
+    return differences;
+}
+
+static void dump_frame(const char *dir, int frame)
+{
+    char path[256];
+    FILE *f;
+    int x, y;
+
+    snprintf(path, sizeof(path), "%s/grey_%05d.pgm", dir, frame);
+    f = fopen(path, "wb");
+    if (!f)
+    {
+        perror(path);
+        return;
+    }
+    fprintf(f, "P5\n%d %d\n%d\n", DISPLAY_WIDTH, DISPLAY_HEIGHT, DISPLAY_GREY_SUBFRAMES);
+    for (y = 0; y < DISPLAY_HEIGHT; y++)
+        for (x = 0; x < DISPLAY_WIDTH; x++)
+            fputc(lit[y][x], f);
+    fclose(f);
+}
@@ -0,0 +1,277 @@
+/**
+ * host/pbm2asset.c
+ * Converts PBM images into C tables in the display's page format, so they
+ * can be sent to the SSD1306 as they are: page by page, each page left to
+ * right, one byte per column with the top row in bit 0. Images are padded
+ * to whole pages with unlit rows.
+ * 
+ *      host/pbm2asset output [raw:|rle:]name=image.pbm ...
+ * 
+ * writes output.c and output.h. A plain name=image.pbm becomes a
+ * struct display_asset, run-length coded when that makes it smaller;
+ * rle: always codes it and raw: makes a bare uint8_t array, like font[].
+ * Other formats can be converted to PBM first, e.g. with ImageMagick's
+ * `convert image.png -monochrome image.pbm`.
+ * 
+ * Run-length coding, decoded by display_asset_read(): a byte c below 0x80
+ * is followed by c + 1 bytes to copy, a byte c from 0x80 up by one byte
+ * to repeat (c & 0x7F) + 3 times.
+*/
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* --------------------------------------------- */
+/* ---------------- Definitions ---------------- */
+
+#define MAX_WIDTH 1024
+#define MAX_HEIGHT 64
+#define MAX_BYTES (MAX_WIDTH * MAX_HEIGHT / 8)
+
+/* Shortest run that is worth a repeat block, and the longest block */
+#define MIN_RUN 3
+#define MAX_RUN (0x7F + MIN_RUN)
+#define MAX_LITERAL 0x80
+
+enum coding
+{
+    CODING_AUTO,
+    CODING_RLE,
+    CODING_RAW
+};
+
+/* --------------------------------------------- */
+/* -------------- Local functions -------------- */
+
+/* Reads the next number of a PBM header, skipping comments */
+static int read_number(FILE *f);
+/* Reads a PBM image into the page format, returns the number of bytes or -1 */
+static int read_pbm(const char *path, int *width, int *pages, unsigned char *out);
+/* Run-length codes data, returns the coded size */
+static int rle_encode(const unsigned char *data, int size, unsigned char *out);
+/* Writes bytes as the body of a C array */
+static void write_bytes(FILE *f, const unsigned char *data, int size);
+
+/* ---------------------------------------------- */
+/* ------------ Function definitions ------------ */
+
+int main(int argc, char **argv)
+{
+    static unsigned char pages_data[MAX_BYTES], coded[MAX_BYTES * 2];
+    char path[512], name[128];
+    const char *item, *file;
+    enum coding coding;
+    FILE *c, *h;
+    int i, size, coded_size, width, pages, rle;
+
+    if (argc < 3)
+    {
+        fprintf(stderr, "usage: %s output [raw:|rle:]name=image.pbm ...\n", argv[0]);
+        return 1;
+    }
+
+    snprintf(path, sizeof(path), "%s.c", argv[1]);
+    c = fopen(path, "w");
+    snprintf(path, sizeof(path), "%s.h", argv[1]);
+    h = fopen(path, "w");
+    if (!c || !h)
+    {
+        perror(argv[1]);
+        return 1;
+    }
+
+    fprintf(c, "/* Generated by host/pbm2asset from the images in assets/, don't edit */\n\n");
+    fprintf(c, "#include \"display.h\"\n\n");
+    fprintf(h, "/* Generated by host/pbm2asset from the images in assets/, don't edit */\n\n");
+    fprintf(h, "#ifndef ASSETS_HEADER\n#define ASSETS_HEADER\n\n#include \"display.h\"\n\n");
+
+    for (i = 2; i < argc; i++)
+    {
+        item = argv[i];
+        coding = CODING_AUTO;
+        if (!strncmp(item, "raw:", 4))
+        {
+            coding = CODING_RAW;
+            item += 4;
+        }
+        else if (!strncmp(item, "rle:", 4))
+        {
+            coding = CODING_RLE;
+            item += 4;
+        }
+
+        file = strchr(item, '=');
+        if (!file || file - item >= (int)sizeof(name))
+        {
+            fprintf(stderr, "%s: expected name=image.pbm\n", item);
+            return 1;
+        }
+        memcpy(name, item, file - item);
+        name[file - item] = '\0';
+        file++;
+
+        size = read_pbm(file, &width, &pages, pages_data);
+        if (size < 0)
+            return 1;
+
+        if (coding == CODING_RAW)
+        {
+            fprintf(c, "/* %s, %dx%d */\nconst uint8_t %s[%d] = {", file, width, pages * 8, name, size);
+            write_bytes(c, pages_data, size);
+            fprintf(c, "};\n\n");
+            fprintf(h, "extern const uint8_t %s[%d];\n", name, size);
+            continue;
+        }
+
+        if (width > 255 || pages > 255)
+        {
+            fprintf(stderr, "%s: too large for a display_asset\n", file);
+            return 1;
+        }
+        coded_size = rle_encode(pages_data, size, coded);
+        rle = coding == CODING_RLE || coded_size < size;
+
+        fprintf(c, "/* %s, %dx%d, %d bytes, %d run-length coded */\n", file, width, pages * 8, size, coded_size);
+        fprintf(c, "static const uint8_t %s_data[] = {", name);
+        write_bytes(c, rle ? coded : pages_data, rle ? coded_size : size);
+        fprintf(c, "};\n");
+        fprintf(c, "const struct display_asset %s = {%d, %d, %s, sizeof(%s_data), %s_data};\n\n",
+                name, width, pages, rle ? "ASSET_RLE" : "0", name, name);
+        fprintf(h, "extern const struct display_asset %s;\n", name);
+    }
+
+    fprintf(h, "\n#endif /* ASSETS_HEADER */\n");
+    fclose(c);
+    fclose(h);
+    return 0;
+}
+
+static int read_number(FILE *f)
+{
+    int ch, n = 0;
+
+    do
+    {
+        ch = fgetc(f);
+        if (ch == '#')
+            while (ch != '\n' && ch != EOF)
+                ch = fgetc(f);
+    } while (isspace(ch));
+
+    if (!isdigit(ch))
+        return -1;
+    while (isdigit(ch))
+    {
+        n = n * 10 + ch - '0';
+        ch = fgetc(f);
+    }
+    return n;
+}
+
+static int read_pbm(const char *path, int *width, int *pages, unsigned char *out)
+{
+    char magic[3] = {0};
+    int w, h, x, y, ch, bit, row_bytes;
+    unsigned char row[MAX_WIDTH / 8];
+    FILE *f = fopen(path, "rb");
+
+    if (!f)
+    {
+        perror(path);
+        return -1;
+    }
+    if (fread(magic, 1, 2, f) != 2 || magic[0] != 'P' || (magic[1] != '1' && magic[1] != '4'))
+    {
+        fprintf(stderr, "%s: not a PBM image\n", path);
+        fclose(f);
+        return -1;
+    }
+    w = read_number(f);
+    h = read_number(f);
+    if (w <= 0 || h <= 0 || w > MAX_WIDTH || h > MAX_HEIGHT)
+    {
+        fprintf(stderr, "%s: size must be up to %dx%d\n", path, MAX_WIDTH, MAX_HEIGHT);
+        fclose(f);
+        return -1;
+    }
+
+    *width = w;
+    *pages = (h + 7) / 8;
+    memset(out, 0, *width * *pages);
+    row_bytes = (w + 7) / 8;
+
+    for (y = 0; y < h; y++)
+    {
+        if (magic[1] == '4' && fread(row, 1, row_bytes, f) != (size_t)row_bytes)
+        {
+            fprintf(stderr, "%s: image data ends early\n", path);
+            fclose(f);
+            return -1;
+        }
+        for (x = 0; x < w; x++)
+        {
+            if (magic[1] == '4')
+                bit = (row[x / 8] >> (7 - x % 8)) & 1;
+            else
+            {
+                do
+                    ch = fgetc(f);
+                while (isspace(ch));
+                if (ch != '0' && ch != '1')
+                {
+                    fprintf(stderr, "%s: image data ends early\n", path);
+                    fclose(f);
+                    return -1;
+                }
+                bit = ch == '1';
+            }
+            // 1 is black in PBM, and a lit pixel on the display
+            if (bit)
+                out[(y / 8) * w + x] |= 1 << (y % 8);
+        }
+    }
+    fclose(f);
+    return *width * *pages;
+}
+
+static int rle_encode(const unsigned char *data, int size, unsigned char *out)
+{
+    int i = 0, n = 0, literal = -1, run;
+
+    while (i < size)
+    {
+        run = 1;
+        while (i + run < size && run < MAX_RUN && data[i + run] == data[i])
+            run++;
+
+        if (run >= MIN_RUN)
+        {
+            literal = -1;
+            out[n++] = 0x80 | (run - MIN_RUN);
+            out[n++] = data[i];
+            i += run;
+            continue;
+        }
+
+        // Add the byte to the current literal block, or start a new one
+        if (literal < 0 || out[literal] == MAX_LITERAL - 1)
+        {
+            literal = n++;
+            out[literal] = 0;
+        }
+        else
+            out[literal]++;
+        out[n++] = data[i++];
+    }
+    return n;
+}
+
+static void write_bytes(FILE *f, const unsigned char *data, int size)
+{
+    int i;
+
+    for (i = 0; i < size; i++)
+        fprintf(f, "%s%s%d,", i % 16 ? "" : "\n", i % 16 ? " " : "\t", data[i]);
+    fprintf(f, "\n");
+}
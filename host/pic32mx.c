@@ -0,0 +1,144 @@
+/**
+ * host/pic32mx.c
+ * Register model behind host/pic32mx.h.
+*/
+#include <time.h>
+#include "pic32mx.h"
+#include "cp0.h"
+
+/* --------------------------------------------- */
+/* ---------------- Definitions ---------------- */
+
+/* SPI2BUF holds this value when nothing has been written to it */
+#define SPI2BUF_EMPTY 0xFFFFFFFFu
+
+/* SPI2STAT bits */
+#define SPIRBF (1 << 0)
+#define SPITBE (1 << 3)
+#define SPIRBE (1 << 5)
+#define SPIROV (1 << 6)
+#define SRMT (1 << 7)
+
+/* SPI2CON bits */
+#define ENHBUF (1 << 16)
+
+/* Depth of the receive FIFO with ENHBUF set, in 8-bit mode */
+#define SPI2_FIFO_DEPTH 16
+
+/* D/C line of the display */
+#define PORTF_DC (1 << 4)
+
+/* --------------------------------------------- */
+/* -------------- Global variables -------------- */
+
+volatile uint32_t host_sfr[HOST_SFR_COUNT];
+void (*host_spi2_sink)(uint8_t byte, int data_mode);
+
+/* --------------------------------------------- */
+/* -------------- Local variables -------------- */
+
+/* Target of the last CLR/SET/INV access, applied on the next access */
+static volatile uint32_t alias_cell;
+static int alias_index = -1;
+static int alias_op;
+
+static int spi2_initialized;
+/* Bytes waiting in the receive buffer or FIFO */
+static int spi2_received;
+
+/* ---------------------------------------------- */
+/* ------------ Function definitions ------------ */
+
+void host_sfr_sync(void)
+{
+    if (!spi2_initialized)
+    {
+        host_sfr[HOST_SPI2BUF] = SPI2BUF_EMPTY;
+        host_sfr[HOST_SPI2STAT] = SPITBE | SPIRBE | SRMT;
+        spi2_initialized = 1;
+    }
+
+    /* Apply a pending write to a CLR/SET/INV alias */
+    if (alias_index >= 0)
+    {
+        switch (alias_op)
+        {
+        case HOST_OP_CLR:
+            host_sfr[alias_index] &= ~alias_cell;
+            break;
+        case HOST_OP_SET:
+            host_sfr[alias_index] |= alias_cell;
+            break;
+        default:
+            host_sfr[alias_index] ^= alias_cell;
+            break;
+        }
+        alias_index = -1;
+    }
+
+    /* A byte written to SPI2BUF is shifted out at once. The transmit
+       buffer and shift register are empty again, which raises the TX
+       interrupt flag whatever STXISEL selects, and a byte has been
+       received. The receive buffer holds one byte, or a FIFO of them with
+       ENHBUF set; receiving into a full one is an overflow. */
+    if (host_sfr[HOST_SPI2BUF] != SPI2BUF_EMPTY)
+    {
+        if (host_spi2_sink)
+            host_spi2_sink(host_sfr[HOST_SPI2BUF] & 0xFF, (host_sfr[HOST_PORTF] & PORTF_DC) != 0);
+        host_sfr[HOST_SPI2BUF] = SPI2BUF_EMPTY;
+        if (spi2_received < (host_sfr[HOST_SPI2CON] & ENHBUF ? SPI2_FIFO_DEPTH : 1))
+            spi2_received++;
+        else
+            host_sfr[HOST_SPI2STAT] |= SPIROV;
+        host_sfr[HOST_SPI2STAT] |= SPIRBF | SPITBE | SRMT;
+        host_sfr[HOST_SPI2STAT] &= ~SPIRBE;
+        host_sfr[HOST_IFS0 + 1] |= HOST_SPI2TX_IRQ_BIT;
+    }
+}
+
+volatile uint32_t *host_sfr_access(int index, int op)
+{
+    host_sfr_sync();
+
+    if (op != HOST_OP_REG)
+    {
+        alias_index = index;
+        alias_op = op;
+        alias_cell = 0;
+        return &alias_cell;
+    }
+
+    /* Reading the receive buffer takes a byte out of it */
+    if (index == HOST_SPI2BUF && spi2_received && --spi2_received == 0)
+    {
+        host_sfr[HOST_SPI2STAT] &= ~SPIRBF;
+        host_sfr[HOST_SPI2STAT] |= SPIRBE;
+    }
+    return &host_sfr[index];
+}
+
+int host_run_interrupts(void (*isr)(void), int max_calls)
+{
+    int calls = 0;
+    int i, pending;
+    do
+    {
+        host_sfr_sync();
+        pending = 0;
+        for (i = 0; i < 3; i++)
+            pending |= host_sfr[HOST_IFS0 + i] & host_sfr[HOST_IEC0 + i];
+        if (pending)
+        {
+            isr();
+            calls++;
+        }
+    } while (pending && calls < max_calls);
+    return calls;
+}
+
+uint32_t cp0_get_count(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint32_t)((uint64_t)ts.tv_sec * CP0_COUNT_HZ + ts.tv_nsec / (1000000000 / CP0_COUNT_HZ));
+}
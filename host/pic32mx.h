@@ -0,0 +1,172 @@
+/**
+ * host/pic32mx.h
+ * Stand-in for the MCB32 toolchain's <pic32mx.h> that lets the display and
+ * game code be compiled and run on a PC, e.g. with
+ * 
+ *      cc -Ihost display.c host/pic32mx.c ...
+ * 
+ * Every special function register is a word in host_sfr[]. Accesses go
+ * through host_sfr_access() so that the SET/CLR/INV aliases, the SPI2
+ * transmit buffer and the interrupt flags behave like on the board: bytes
+ * written to SPI2BUF are "sent" immediately, handed to host_spi2_sink
+ * together with the display's D/C line, and raise the SPI2 TX interrupt
+ * flag. Interrupt handlers are run with host_run_interrupts().
+*/
+#ifndef HOST_PIC32MX_HEADER
+#define HOST_PIC32MX_HEADER
+
+#include <stdint.h>
+
+/* --------------------------------------------- */
+/* ---------------- Definitions ---------------- */
+
+/* Register indices into host_sfr[] */
+enum host_sfr_index
+{
+    HOST_SYSKEY,
+    HOST_OSCCON,
+    HOST_INTCON,
+    HOST_TRISD,
+    HOST_TRISF,
+    HOST_TRISG,
+    HOST_PORTD,
+    HOST_PORTF,
+    HOST_PORTG,
+    HOST_ODCF,
+    HOST_ODCG,
+    HOST_T2CON,
+    HOST_TMR2,
+    HOST_PR2,
+    HOST_T3CON,
+    HOST_TMR3,
+    HOST_PR3,
+    HOST_SPI2CON,
+    HOST_SPI2STAT,
+    HOST_SPI2BUF,
+    HOST_SPI2BRG,
+    HOST_IFS0,
+    HOST_IEC0 = HOST_IFS0 + 3,
+    HOST_IPC0 = HOST_IEC0 + 3,
+    HOST_SFR_COUNT = HOST_IPC0 + 13
+};
+
+/* Which part of a register an access refers to */
+enum host_sfr_op
+{
+    HOST_OP_REG,
+    HOST_OP_CLR,
+    HOST_OP_SET,
+    HOST_OP_INV
+};
+
+/* Bit in IFS(1)/IEC(1) for the SPI2 transmit interrupt (IRQ 38) */
+#define HOST_SPI2TX_IRQ_BIT (1 << 6)
+
+#define HOST_SFR(i, op) (*host_sfr_access((i), (op)))
+
+#define SYSKEY HOST_SFR(HOST_SYSKEY, HOST_OP_REG)
+#define OSCCON HOST_SFR(HOST_OSCCON, HOST_OP_REG)
+#define OSCCONCLR HOST_SFR(HOST_OSCCON, HOST_OP_CLR)
+#define OSCCONSET HOST_SFR(HOST_OSCCON, HOST_OP_SET)
+#define INTCON HOST_SFR(HOST_INTCON, HOST_OP_REG)
+#define INTCONCLR HOST_SFR(HOST_INTCON, HOST_OP_CLR)
+#define INTCONSET HOST_SFR(HOST_INTCON, HOST_OP_SET)
+
+#define TRISD HOST_SFR(HOST_TRISD, HOST_OP_REG)
+#define TRISDCLR HOST_SFR(HOST_TRISD, HOST_OP_CLR)
+#define TRISDSET HOST_SFR(HOST_TRISD, HOST_OP_SET)
+#define TRISF HOST_SFR(HOST_TRISF, HOST_OP_REG)
+#define TRISFCLR HOST_SFR(HOST_TRISF, HOST_OP_CLR)
+#define TRISFSET HOST_SFR(HOST_TRISF, HOST_OP_SET)
+#define TRISG HOST_SFR(HOST_TRISG, HOST_OP_REG)
+#define TRISGCLR HOST_SFR(HOST_TRISG, HOST_OP_CLR)
+#define TRISGSET HOST_SFR(HOST_TRISG, HOST_OP_SET)
+#define PORTD HOST_SFR(HOST_PORTD, HOST_OP_REG)
+#define PORTF HOST_SFR(HOST_PORTF, HOST_OP_REG)
+#define PORTFCLR HOST_SFR(HOST_PORTF, HOST_OP_CLR)
+#define PORTFSET HOST_SFR(HOST_PORTF, HOST_OP_SET)
+#define PORTG HOST_SFR(HOST_PORTG, HOST_OP_REG)
+#define PORTGCLR HOST_SFR(HOST_PORTG, HOST_OP_CLR)
+#define PORTGSET HOST_SFR(HOST_PORTG, HOST_OP_SET)
+#define ODCF HOST_SFR(HOST_ODCF, HOST_OP_REG)
+#define ODCG HOST_SFR(HOST_ODCG, HOST_OP_REG)
+
+#define T2CON HOST_SFR(HOST_T2CON, HOST_OP_REG)
+#define T2CONCLR HOST_SFR(HOST_T2CON, HOST_OP_CLR)
+#define T2CONSET HOST_SFR(HOST_T2CON, HOST_OP_SET)
+#define TMR2 HOST_SFR(HOST_TMR2, HOST_OP_REG)
+#define PR2 HOST_SFR(HOST_PR2, HOST_OP_REG)
+
+#define T3CON HOST_SFR(HOST_T3CON, HOST_OP_REG)
+#define T3CONCLR HOST_SFR(HOST_T3CON, HOST_OP_CLR)
+#define T3CONSET HOST_SFR(HOST_T3CON, HOST_OP_SET)
+#define TMR3 HOST_SFR(HOST_TMR3, HOST_OP_REG)
+#define PR3 HOST_SFR(HOST_PR3, HOST_OP_REG)
+
+#define SPI2CON HOST_SFR(HOST_SPI2CON, HOST_OP_REG)
+#define SPI2CONCLR HOST_SFR(HOST_SPI2CON, HOST_OP_CLR)
+#define SPI2CONSET HOST_SFR(HOST_SPI2CON, HOST_OP_SET)
+#define SPI2STAT HOST_SFR(HOST_SPI2STAT, HOST_OP_REG)
+#define SPI2STATCLR HOST_SFR(HOST_SPI2STAT, HOST_OP_CLR)
+#define SPI2STATSET HOST_SFR(HOST_SPI2STAT, HOST_OP_SET)
+#define SPI2BUF HOST_SFR(HOST_SPI2BUF, HOST_OP_REG)
+#define SPI2BRG HOST_SFR(HOST_SPI2BRG, HOST_OP_REG)
+#define SPI2BRGCLR HOST_SFR(HOST_SPI2BRG, HOST_OP_CLR)
+#define SPI2BRGSET HOST_SFR(HOST_SPI2BRG, HOST_OP_SET)
+
+#define IFS(x) HOST_SFR(HOST_IFS0 + (x), HOST_OP_REG)
+#define IFSCLR(x) HOST_SFR(HOST_IFS0 + (x), HOST_OP_CLR)
+#define IFSSET(x) HOST_SFR(HOST_IFS0 + (x), HOST_OP_SET)
+#define IEC(x) HOST_SFR(HOST_IEC0 + (x), HOST_OP_REG)
+#define IECCLR(x) HOST_SFR(HOST_IEC0 + (x), HOST_OP_CLR)
+#define IECSET(x) HOST_SFR(HOST_IEC0 + (x), HOST_OP_SET)
+#define IPC(x) HOST_SFR(HOST_IPC0 + (x), HOST_OP_REG)
+#define IPCCLR(x) HOST_SFR(HOST_IPC0 + (x), HOST_OP_CLR)
+#define IPCSET(x) HOST_SFR(HOST_IPC0 + (x), HOST_OP_SET)
+
+/* -------------------------------------------- */
+/* ------- Extern variable declarations ------- */
+
+/* The register file */
+extern volatile uint32_t host_sfr[HOST_SFR_COUNT];
+
+/**
+ * @brief   Called for every byte shifted out of SPI2.
+ *          data_mode is 1 when the display's D/C line (RF4) is high,
+ *          i.e. the byte is pixel data, and 0 for command bytes.
+ *          May be NULL.
+*/
+extern void (*host_spi2_sink)(uint8_t byte, int data_mode);
+
+/* --------------------------------------------- */
+/* ----------- Function declarations ----------- */
+
+/**
+ * @brief   Returns a pointer through which the register is read or
+ *          written. Writes made through the previously returned pointer
+ *          are applied first, so accesses take effect in program order.
+ * 
+ * @param index     register index, see enum host_sfr_index
+ * @param op        HOST_OP_REG for the register itself, otherwise the
+ *                  CLR/SET/INV alias
+*/
+volatile uint32_t *host_sfr_access(int index, int op);
+
+/**
+ * @brief   Applies any register write that hasn't been seen yet.
+ *          Call after the last access of a sequence, e.g. before checking
+ *          what was sent to the display.
+*/
+void host_sfr_sync(void);
+
+/**
+ * @brief   Calls isr while any interrupt that is both enabled (IEC) and
+ *          flagged (IFS) is pending, like the CPU would.
+ * 
+ * @param isr           the interrupt handler, e.g. user_isr
+ * @param max_calls     upper bound on the number of calls
+ * @return              number of times isr was called
+*/
+int host_run_interrupts(void (*isr)(void), int max_calls);
+
+#endif /* HOST_PIC32MX_HEADER */
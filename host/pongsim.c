@@ -0,0 +1,421 @@
+/**
+ * host/pongsim.c
+ * Runs the game without the board: the AI plays player 1, player 2 follows
+ * the ball, and frames are drawn into a display in memory. Prints how long
+ * rendering and flushing took and optionally writes frames as PBM images.
+ * 
+ *      host/pongsim [-n frames] [-d dump interval] [-o dump directory]
+ *                   [-b memory|ssd1306]
+ * 
+ * With -b ssd1306 frames go through the real SSD1306 backend and its SPI2
+ * interrupt handler into the controller model in ssd1306_emu.c. Every
+ * frame the model's memory is compared with what should have been sent,
+ * and the bytes on the bus are counted.
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "main.h"
+#include "assets.h"
+#include "display_memory.h"
+#include "ssd1306_emu.h"
+
+/* --------------------------------------------- */
+/* ---------------- Definitions ---------------- */
+
+#define DEFAULT_FRAMES 1000
+/* Interrupts allowed per frame before giving up on a flush */
+#define MAX_ISR_CALLS 100000
+
+/* --------------------------------------------- */
+/* -------------- Local variables -------------- */
+
+static int use_ssd1306;
+
+/* --------------------------------------------- */
+/* -------------- Local functions -------------- */
+
+/* Monotonic time in nanoseconds */
+static uint64_t now_ns(void);
+/* Moves a paddle one pixel towards the ball */
+static void follow_ball(struct paddle *p, struct ball *b);
+/* Writes the last flushed frame to dir/frame_NNNNN.pbm */
+static void dump_frame(const char *dir, int frame);
+/* Prints the times of the profiled sections, see profile.h */
+static void print_profile(void);
+/* Makes sprites from bitmaps larger than a sprite holds, returns how many
+   came out wrong */
+static int check_sprites(void);
+/* Number of bytes in the controller model's memory that differ from the
+   memory display */
+static int compare_with_emulator(void);
+
+/* The SSD1306 backend, with every window also copied to the memory display
+   so there's something to compare the controller model with */
+static void checked_init(void);
+static uint16_t checked_flush(const uint32_t *data);
+static uint16_t checked_flush_region(const uint32_t *data, uint8_t page, uint8_t x0, uint8_t x1);
+static uint16_t checked_flush_async(const uint32_t *data, const struct display_window *window, void (*done)(void));
+static bool checked_busy(void);
+static void checked_set_page_base(uint8_t page);
+static void checked_set_start_line(uint8_t line);
+static void checked_scroll(int8_t direction, uint8_t page0, uint8_t page1, uint8_t interval);
+static uint16_t checked_stream(const struct display_asset *asset, uint8_t x, uint8_t page);
+
+static const struct display_backend checked_backend = {
+    checked_init,
+    checked_flush,
+    checked_flush_region,
+    checked_flush_async,
+    checked_busy,
+    checked_set_page_base,
+    checked_set_start_line,
+    checked_scroll,
+    checked_stream,
+    NULL,
+};
+
+/* ---------------------------------------------- */
+/* ------------ Function definitions ------------ */
+
+int main(int argc, char **argv)
+{
+    int frames = DEFAULT_FRAMES;
+    int dump_interval = 0;
+    const char *dump_dir = ".";
+    uint64_t render_ns = 0, flush_ns = 0, max_frame_ns = 0;
+    uint64_t bytes = 0, t0, t1, t2;
+    struct ssd1306_emu_stats frame_stats, startup;
+    int games = 0, mismatched_frames = 0;
+    int i, opt;
+
+    while ((opt = getopt(argc, argv, "n:d:o:b:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'n':
+            frames = atoi(optarg);
+            break;
+        case 'd':
+            dump_interval = atoi(optarg);
+            break;
+        case 'o':
+            dump_dir = optarg;
+            break;
+        case 'b':
+            if (!strcmp(optarg, "ssd1306"))
+                use_ssd1306 = 1;
+            else if (strcmp(optarg, "memory"))
+            {
+                fprintf(stderr, "unknown backend '%s'\n", optarg);
+                return 1;
+            }
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-n frames] [-d dump interval] [-o dump directory] "
+                            "[-b memory|ssd1306]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (use_ssd1306)
+    {
+        // SPI2 like initialize_system() sets it up
+        SPI2BRG = DISPLAY_SPI_BRG;
+        SPI2CON = 0x10000 | 0x8000 | 0x40 | 0x20;
+        ssd1306_emu_attach();
+        display_set_backend(&checked_backend);
+    }
+    else
+        display_set_backend(&display_memory_backend);
+
+    display_init();
+    // The splash screen like at boot, streamed past the screen data buffer
+    display_stream_asset(&asset_splash, 0, 0);
+    host_sfr_sync();
+    if (use_ssd1306 && compare_with_emulator())
+    {
+        fprintf(stderr, "the splash screen was streamed wrong\n");
+        mismatched_frames++;
+    }
+    if (check_sprites())
+        mismatched_frames++;
+    render_init();
+    pong_initialize_game(&player1, &player2, &the_ball, GAME_PVM);
+    // The power-up sequence and first full frame aren't part of any frame
+    host_sfr_sync();
+    ssd1306_emu_end_frame(&startup);
+
+    for (i = 0; i < frames; i++)
+    {
+        if (player1.score >= WIN_SCORE || player2.score >= WIN_SCORE)
+        {
+            pong_initialize_game(&player1, &player2, &the_ball, GAME_PVM);
+            render_invalidate();
+            games++;
+        }
+
+        PROFILE_BEGIN(PROFILE_AI);
+        pong_ai_run(&player1, &the_ball, 0x4, 1.f);
+        PROFILE_END(PROFILE_AI);
+        follow_ball(&player2, &the_ball);
+        PROFILE_BEGIN(PROFILE_PHYSICS);
+        pong_move_ball(&player1, &player2, &the_ball, 1.f);
+        PROFILE_END(PROFILE_PHYSICS);
+
+        t0 = now_ns();
+        PROFILE_BEGIN(PROFILE_RENDER);
+        render_game(&player1, &player2, &the_ball);
+        PROFILE_END(PROFILE_RENDER);
+        t1 = now_ns();
+        if (use_ssd1306)
+        {
+            // Like the game: start the flush, then let the SPI2 interrupt send it
+            display_update_async();
+            host_run_interrupts(display_spi_isr, MAX_ISR_CALLS);
+        }
+        else
+            display_update();
+        t2 = now_ns();
+
+        render_ns += t1 - t0;
+        flush_ns += t2 - t1;
+        if (t2 - t0 > max_frame_ns)
+            max_frame_ns = t2 - t0;
+        bytes += display_get_bytes_sent();
+
+        if (use_ssd1306)
+        {
+            // Deliver the last byte written to SPI2BUF
+            host_sfr_sync();
+            ssd1306_emu_end_frame(&frame_stats);
+            if (display_update_busy() || compare_with_emulator())
+            {
+                if (!mismatched_frames)
+                    fprintf(stderr, "frame %d: the display doesn't show the frame\n", i);
+                mismatched_frames++;
+            }
+        }
+
+        if (dump_interval > 0 && i % dump_interval == 0)
+            dump_frame(dump_dir, i);
+    }
+
+    if (frames > 0)
+    {
+        printf("frames          %d (%d games finished)\n", frames, games);
+        printf("render          %.1f us/frame\n", render_ns / 1e3 / frames);
+        printf("flush           %.1f us/frame\n", flush_ns / 1e3 / frames);
+        printf("worst frame     %.1f us\n", max_frame_ns / 1e3);
+        printf("display bytes   %.1f /frame\n", (double)bytes / frames);
+        print_profile();
+    }
+    if (use_ssd1306 && frames > 0)
+    {
+        const struct ssd1306_emu_stats *total = ssd1306_emu_totals();
+        printf("startup         %u command bytes, %u data bytes\n",
+               startup.command_bytes, startup.data_bytes);
+        printf("command bytes   %.1f /frame (%.1f commands)\n",
+               (double)(total->command_bytes - startup.command_bytes) / frames,
+               (double)(total->commands - startup.commands) / frames);
+        printf("data bytes      %.1f /frame\n", (double)(total->data_bytes - startup.data_bytes) / frames);
+        printf("redundant       %.1f /frame\n",
+               (double)(total->redundant_writes - startup.redundant_writes) / frames);
+        printf("D/C switches    %.1f /frame\n", (double)(total->mode_switches - startup.mode_switches) / frames);
+        printf("errors          %u\n", total->errors);
+        printf("wrong frames    %d\n", mismatched_frames);
+    }
+    return mismatched_frames || (use_ssd1306 && ssd1306_emu_totals()->errors) ? 2 : 0;
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + ts.tv_nsec;
+}
+
+static void follow_ball(struct paddle *p, struct ball *b)
+{
+    float centre = p->y + P_HEIGHT / 2.f;
+
+    if (b->y > centre && p->y + P_HEIGHT < 31)
+        pong_move_paddle(p, 1.f, 1.f);
+    else if (b->y < centre && p->y > 1.f)
+        pong_move_paddle(p, -1.f, 1.f);
+}
+
+static int check_sprites(void)
+{
+    // Wider and taller than a sprite, and wider only
+    static const uint8_t sizes[][2] = {{40, 40}, {40, 12}, {20, 40}};
+    static uint8_t data[40 * 5];
+    struct display_sprite sprite;
+    uint32_t expected;
+    int wrong = 0, n, i, j;
+
+    for (i = 0; i < (int)sizeof(data); i++)
+        data[i] = i * 37 + 11;
+
+    for (n = 0; n < (int)(sizeof(sizes) / sizeof(sizes[0])); n++)
+    {
+        int width = sizes[n][0], height = sizes[n][1];
+
+        display_sprite_from_pages(&sprite, data, width, height);
+        if (width > DISPLAY_SPRITE_MAX_WIDTH)
+            width = DISPLAY_SPRITE_MAX_WIDTH;
+        if (height > DISPLAY_HEIGHT)
+            height = DISPLAY_HEIGHT;
+        if (sprite.width != width || sprite.height != height)
+        {
+            fprintf(stderr, "%dx%d sprite: got %ux%u\n", sizes[n][0], sizes[n][1], sprite.width, sprite.height);
+            wrong++;
+            continue;
+        }
+        for (i = 0; i < width; i++)
+        {
+            // Row y is bit y % 8 of data[y / 8 * the bitmap's width + i]
+            expected = 0;
+            for (j = 0; j < height; j++)
+                expected |= (uint32_t)(data[j / 8 * sizes[n][0] + i] >> (j % 8) & 1) << j;
+            if (sprite.columns[i] != expected)
+            {
+                fprintf(stderr, "%dx%d sprite: column %d is %08x, not %08x\n",
+                        sizes[n][0], sizes[n][1], i, sprite.columns[i], expected);
+                wrong++;
+                break;
+            }
+        }
+    }
+    return wrong;
+}
+
+static void print_profile(void)
+{
+#if PROFILE
+    const struct profile_stats *s;
+    int i, j, last;
+
+    printf("section         calls      min     mean      max us   log2 histogram\n");
+    for (i = 0; i < PROFILE_SECTIONS; i++)
+    {
+        s = profile_get(i);
+        if (!s->count)
+            continue;
+        printf("%-12s %8u %8.2f %8.2f %8.2f      ", profile_names[i], s->count,
+               (double)s->min / CP0_TICKS_PER_US,
+               (double)s->total / s->count / CP0_TICKS_PER_US,
+               (double)s->max / CP0_TICKS_PER_US);
+        // From the first to the last bucket used
+        for (last = PROFILE_BUCKETS - 1; !s->histogram[last]; last--)
+            ;
+        for (j = 0; !s->histogram[j]; j++)
+            ;
+        if (j > 0)
+            printf("2^%d:", j - 1);
+        else
+            printf("0:");
+        for (; j <= last; j++)
+            printf(" %u", s->histogram[j]);
+        printf("\n");
+    }
+    s = profile_get(PROFILE_TEXT);
+    if (s->count)
+        printf("text            %.0f cycles/glyph, host time counted at the board's 80 MHz\n",
+               (double)s->total / s->count * CP0_CYCLES_PER_TICK);
+#endif
+}
+
+static void dump_frame(const char *dir, int frame)
+{
+    char path[256];
+    FILE *f;
+
+    snprintf(path, sizeof(path), "%s/frame_%05d.pbm", dir, frame);
+    f = fopen(path, "wb");
+    if (!f)
+    {
+        perror(path);
+        return;
+    }
+    // With the SSD1306 backend, dump what the panel shows
+    if (use_ssd1306)
+        ssd1306_emu_write_pbm(f);
+    else
+        display_memory_write_pbm(f);
+    fclose(f);
+}
+
+static int compare_with_emulator(void)
+{
+    const uint8_t (*expected)[DISPLAY_WIDTH] = display_memory_pages();
+    const uint8_t (*gddram)[SSD1306_EMU_COLUMNS] = ssd1306_emu_gddram();
+    int differences = 0;
+    int page, x;
+
+    for (page = 0; page < DISPLAY_MEMORY_PAGES; page++)
+        for (x = 0; x < DISPLAY_WIDTH; x++)
+            differences += expected[page][x] != gddram[page][x];
+    // Both must show the same lines
+    return differences + (display_get_start_line() != ssd1306_emu_start_line());
+}
+
+static void checked_init(void)
+{
+    display_memory_backend.init();
+    display_ssd1306_backend.init();
+}
+
+static uint16_t checked_flush(const uint32_t *data)
+{
+    display_memory_backend.flush(data);
+    return display_ssd1306_backend.flush(data);
+}
+
+static uint16_t checked_flush_region(const uint32_t *data, uint8_t page, uint8_t x0, uint8_t x1)
+{
+    display_memory_backend.flush_region(data, page, x0, x1);
+    return display_ssd1306_backend.flush_region(data, page, x0, x1);
+}
+
+static uint16_t checked_flush_async(const uint32_t *data, const struct display_window *window,
+                                    void (*done)(void))
+{
+    uint8_t page;
+
+    for (page = 0; page < DISPLAY_ROW_SETS; page++)
+        if (window->pages & (1 << page))
+            display_memory_backend.flush_region(data, page, window->x0[page], window->x1[page]);
+    return display_ssd1306_backend.flush_async(data, window, done);
+}
+
+static bool checked_busy(void)
+{
+    return display_ssd1306_backend.busy();
+}
+
+static void checked_set_page_base(uint8_t page)
+{
+    display_memory_backend.set_page_base(page);
+    display_ssd1306_backend.set_page_base(page);
+}
+
+static void checked_set_start_line(uint8_t line)
+{
+    display_memory_backend.set_start_line(line);
+    display_ssd1306_backend.set_start_line(line);
+}
+
+static void checked_scroll(int8_t direction, uint8_t page0, uint8_t page1, uint8_t interval)
+{
+    // The memory display can't scroll, the frame after a scroll is sent whole
+    display_ssd1306_backend.scroll(direction, page0, page1, interval);
+}
+
+static uint16_t checked_stream(const struct display_asset *asset, uint8_t x, uint8_t page)
+{
+    display_memory_backend.stream(asset, x, page);
+    return display_ssd1306_backend.stream(asset, x, page);
+}
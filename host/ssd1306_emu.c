@@ -0,0 +1,344 @@
+/**
+ * host/ssd1306_emu.c
+ * Model of the SSD1306 OLED controller, see the SSD1306 datasheet for the
+ * commands.
+ * 
+ * The column and page address commands (0x21, 0x22) also move the write
+ * pointer in page addressing mode: the original display_image() relies on
+ * this, and the panel on the I/O board behaves that way.
+*/
+#include <string.h>
+#include <pic32mx.h>
+#include "ssd1306_emu.h"
+
+/* --------------------------------------------- */
+/* ---------------- Definitions ---------------- */
+
+/* Longest argument list, the 0x26/0x27 horizontal scroll setup */
+#define MAX_ARGUMENTS 6
+
+/* --------------------------------------------- */
+/* -------------- Local variables -------------- */
+
+static uint8_t gddram[SSD1306_EMU_PAGES][SSD1306_EMU_COLUMNS];
+
+/* Addressing */
+static uint8_t addressing_mode;
+static uint8_t column, page;
+static uint8_t column_start, column_end;
+static uint8_t page_start, page_end;
+
+/* Display */
+static uint8_t start_line;
+static uint8_t display_offset;
+static uint8_t display_on;
+static uint8_t scrolling;
+static uint8_t scroll_setup[MAX_ARGUMENTS];
+
+/* Command being received */
+static uint8_t command;
+static uint8_t arguments[MAX_ARGUMENTS];
+static uint8_t arguments_needed;
+static uint8_t arguments_received;
+static int last_data_mode = -1;
+
+static struct ssd1306_emu_stats frame_stats;
+static struct ssd1306_emu_stats total_stats;
+
+/* --------------------------------------------- */
+/* -------------- Local functions -------------- */
+
+/* Number of argument bytes a command takes, -1 if the command is unknown */
+static int command_arguments(uint8_t cmd);
+/* Runs a command once all of its arguments have been received */
+static void run_command(void);
+/* Writes a byte to the GDDRAM and moves the write pointer */
+static void write_data(uint8_t byte);
+
+/* Adds to both the frame and the total counts */
+#define COUNT(field) (frame_stats.field++, total_stats.field++)
+
+/* ---------------------------------------------- */
+/* ------------ Function definitions ------------ */
+
+void ssd1306_emu_reset(void)
+{
+    memset(gddram, 0, sizeof(gddram));
+    addressing_mode = SSD1306_EMU_PAGE;
+    column = page = 0;
+    column_start = 0;
+    column_end = SSD1306_EMU_COLUMNS - 1;
+    page_start = 0;
+    page_end = SSD1306_EMU_PAGES - 1;
+
+    start_line = 0;
+    display_offset = 0;
+    display_on = 0;
+    scrolling = 0;
+
+    arguments_needed = arguments_received = 0;
+    last_data_mode = -1;
+    memset(&frame_stats, 0, sizeof(frame_stats));
+    memset(&total_stats, 0, sizeof(total_stats));
+}
+
+void ssd1306_emu_attach(void)
+{
+    ssd1306_emu_reset();
+    host_spi2_sink = ssd1306_emu_write;
+}
+
+void ssd1306_emu_write(uint8_t byte, int data_mode)
+{
+    int needed;
+
+    if (last_data_mode >= 0 && data_mode != last_data_mode)
+        COUNT(mode_switches);
+    last_data_mode = data_mode;
+
+    if (data_mode)
+    {
+        COUNT(data_bytes);
+        // D/C went high before the command had all of its arguments
+        if (arguments_needed)
+        {
+            COUNT(errors);
+            arguments_needed = 0;
+        }
+        write_data(byte);
+        return;
+    }
+
+    COUNT(command_bytes);
+    if (arguments_needed)
+    {
+        arguments[arguments_received++] = byte;
+        if (arguments_received == arguments_needed)
+        {
+            arguments_needed = 0;
+            run_command();
+        }
+        return;
+    }
+
+    COUNT(commands);
+    needed = command_arguments(byte);
+    if (needed < 0)
+    {
+        COUNT(errors);
+        return;
+    }
+    command = byte;
+    arguments_received = 0;
+    arguments_needed = needed;
+    if (!needed)
+        run_command();
+}
+
+void ssd1306_emu_end_frame(struct ssd1306_emu_stats *frame)
+{
+    if (frame)
+        *frame = frame_stats;
+    memset(&frame_stats, 0, sizeof(frame_stats));
+}
+
+const struct ssd1306_emu_stats *ssd1306_emu_totals(void)
+{
+    return &total_stats;
+}
+
+const uint8_t (*ssd1306_emu_gddram(void))[SSD1306_EMU_COLUMNS]
+{
+    return (const uint8_t (*)[SSD1306_EMU_COLUMNS])gddram;
+}
+
+uint8_t ssd1306_emu_start_line(void)
+{
+    return start_line;
+}
+
+int ssd1306_emu_scrolling(void)
+{
+    return scrolling;
+}
+
+int ssd1306_emu_display_on(void)
+{
+    return display_on;
+}
+
+int ssd1306_emu_pixel(int x, int y)
+{
+    int line;
+
+    if (x < 0 || x >= SSD1306_EMU_COLUMNS || y < 0 || y >= SSD1306_EMU_PANEL_ROWS)
+        return 0;
+    line = (y + start_line + display_offset) % SSD1306_EMU_LINES;
+    return (gddram[line / 8][x] >> (line % 8)) & 1;
+}
+
+int ssd1306_emu_write_pbm(FILE *f)
+{
+    uint8_t row[SSD1306_EMU_COLUMNS / 8];
+    int x, y;
+
+    fprintf(f, "P4\n%d %d\n", SSD1306_EMU_COLUMNS, SSD1306_EMU_PANEL_ROWS);
+    for (y = 0; y < SSD1306_EMU_PANEL_ROWS; y++)
+    {
+        memset(row, 0, sizeof(row));
+        for (x = 0; x < SSD1306_EMU_COLUMNS; x++)
+            if (ssd1306_emu_pixel(x, y))
+                row[x / 8] |= 0x80 >> (x % 8);
+        if (fwrite(row, 1, sizeof(row), f) != sizeof(row))
+            return -1;
+    }
+    return 0;
+}
+
+static int command_arguments(uint8_t cmd)
+{
+    // Commands with the argument in the low bits
+    if (cmd <= 0x1F || (cmd >= 0x40 && cmd <= 0x7F) || (cmd >= 0xB0 && cmd <= 0xB7))
+        return 0;
+
+    switch (cmd)
+    {
+    case 0x2E: // Deactivate scroll
+    case 0x2F: // Activate scroll
+    case 0xA0: // Segment remap
+    case 0xA1:
+    case 0xA4: // Entire display on
+    case 0xA5:
+    case 0xA6: // Normal / inverse
+    case 0xA7:
+    case 0xAE: // Display off / on
+    case 0xAF:
+    case 0xC0: // COM scan direction
+    case 0xC8:
+    case 0xE3: // NOP
+        return 0;
+    case 0x20: // Memory addressing mode
+    case 0x81: // Contrast
+    case 0x8D: // Charge pump
+    case 0xA8: // Multiplex ratio
+    case 0xD3: // Display offset
+    case 0xD5: // Clock divide
+    case 0xD9: // Pre-charge period
+    case 0xDA: // COM pins
+    case 0xDB: // VCOMH level
+        return 1;
+    case 0x21: // Column address
+    case 0x22: // Page address
+    case 0xA3: // Vertical scroll area
+        return 2;
+    case 0x29: // Vertical and horizontal scroll setup
+    case 0x2A:
+        return 5;
+    case 0x26: // Horizontal scroll setup
+    case 0x27:
+        return 6;
+    default:
+        return -1;
+    }
+}
+
+static void run_command(void)
+{
+    if (command <= 0x0F)
+    {
+        if (addressing_mode == SSD1306_EMU_PAGE)
+            column = (column & 0x70) | command;
+        return;
+    }
+    if (command <= 0x1F)
+    {
+        if (addressing_mode == SSD1306_EMU_PAGE)
+            column = ((command & 0x7) << 4) | (column & 0x0F);
+        return;
+    }
+    if (command >= 0x40 && command <= 0x7F)
+    {
+        start_line = command & 0x3F;
+        return;
+    }
+    if (command >= 0xB0 && command <= 0xB7)
+    {
+        if (addressing_mode == SSD1306_EMU_PAGE)
+            page = command & 0x7;
+        return;
+    }
+
+    switch (command)
+    {
+    case 0x20:
+        // 3 is invalid and ignored by the controller
+        if ((arguments[0] & 0x3) != 0x3)
+            addressing_mode = arguments[0] & 0x3;
+        break;
+    case 0x21:
+        column_start = column = arguments[0] & 0x7F;
+        column_end = arguments[1] & 0x7F;
+        break;
+    case 0x22:
+        page_start = page = arguments[0] & 0x7;
+        page_end = arguments[1] & 0x7;
+        break;
+    case 0x26:
+    case 0x27:
+    case 0x29:
+    case 0x2A:
+        memcpy(scroll_setup, arguments, sizeof(scroll_setup));
+        break;
+    case 0x2E:
+        scrolling = 0;
+        break;
+    case 0x2F:
+        scrolling = 1;
+        break;
+    case 0xAE:
+        display_on = 0;
+        break;
+    case 0xAF:
+        display_on = 1;
+        break;
+    case 0xD3:
+        display_offset = arguments[0] & 0x3F;
+        break;
+    default:
+        // Contrast, charge pump, remapping etc. don't change what is stored
+        break;
+    }
+}
+
+static void write_data(uint8_t byte)
+{
+    // The datasheet leaves the GDDRAM undefined when written while scrolling
+    if (scrolling)
+        COUNT(errors);
+
+    if (gddram[page][column] == byte)
+        COUNT(redundant_writes);
+    gddram[page][column] = byte;
+
+    switch (addressing_mode)
+    {
+    case SSD1306_EMU_HORIZONTAL:
+        if (column++ >= column_end)
+        {
+            column = column_start;
+            page = page >= page_end ? page_start : page + 1;
+        }
+        break;
+    case SSD1306_EMU_VERTICAL:
+        if (page++ >= page_end)
+        {
+            page = page_start;
+            column = column >= column_end ? column_start : column + 1;
+        }
+        break;
+    default:
+        // Page addressing wraps within the page
+        column = (column + 1) % SSD1306_EMU_COLUMNS;
+        break;
+    }
+}
@@ -0,0 +1,116 @@
+/**
+ * host/ssd1306_emu.h
+ * Model of the OLED's SSD1306 controller. It takes the bytes written to
+ * SPI2 together with the D/C line, runs the commands and keeps the
+ * controller's display memory (GDDRAM), so that what ends up on the panel
+ * can be checked and the cost of sending it counted without the board.
+*/
+#ifndef HOST_SSD1306_EMU_HEADER
+#define HOST_SSD1306_EMU_HEADER
+
+#include <stdint.h>
+#include <stdio.h>
+
+/* --------------------------------------------- */
+/* ---------------- Definitions ---------------- */
+
+#define SSD1306_EMU_PAGES 8
+#define SSD1306_EMU_COLUMNS 128
+#define SSD1306_EMU_LINES (SSD1306_EMU_PAGES * 8)
+/* Rows of the I/O board's panel */
+#define SSD1306_EMU_PANEL_ROWS 32
+
+/* Values of the 0x20 memory addressing mode command */
+#define SSD1306_EMU_HORIZONTAL 0
+#define SSD1306_EMU_VERTICAL 1
+#define SSD1306_EMU_PAGE 2
+
+/**
+ * @brief   Byte counts, either for one frame or since the last reset.
+*/
+struct ssd1306_emu_stats
+{
+    uint32_t command_bytes;     // Bytes sent with D/C low, arguments included
+    uint32_t commands;          // Commands, not counting their arguments
+    uint32_t data_bytes;        // Bytes sent with D/C high
+    uint32_t redundant_writes;  // Data bytes that didn't change the GDDRAM
+    uint32_t mode_switches;     // Changes of the D/C line between bytes
+    uint32_t errors;            // Unknown commands, data in the middle of a
+                                // command, writes while scrolling
+};
+
+/* --------------------------------------------- */
+/* ----------- Function declarations ----------- */
+
+/**
+ * @brief   Puts the controller in its power-on state: empty GDDRAM, page
+ *          addressing, start line 0, no scrolling, display off. Clears
+ *          all counters.
+*/
+void ssd1306_emu_reset(void);
+
+/**
+ * @brief   Resets the controller and connects it to SPI2 of the host
+ *          stand-in, so that every byte the display code sends is fed to
+ *          ssd1306_emu_write().
+*/
+void ssd1306_emu_attach(void);
+
+/**
+ * @brief   Takes one byte from the bus.
+ * 
+ * @param byte      the byte
+ * @param data_mode 1 if the D/C line was high (data), 0 for commands
+*/
+void ssd1306_emu_write(uint8_t byte, int data_mode);
+
+/**
+ * @brief   Ends a frame: copies the counts since the last call into
+ *          frame (if not NULL) and starts counting the next frame.
+*/
+void ssd1306_emu_end_frame(struct ssd1306_emu_stats *frame);
+
+/**
+ * @brief   Counts since the last reset.
+*/
+const struct ssd1306_emu_stats *ssd1306_emu_totals(void);
+
+/**
+ * @brief   The GDDRAM, byte [page][column] holds lines 8*page to
+ *          8*page + 7 of the column, lowest line in bit 0.
+*/
+const uint8_t (*ssd1306_emu_gddram(void))[SSD1306_EMU_COLUMNS];
+
+/**
+ * @brief   GDDRAM line shown on the top row of the panel, set by the
+ *          0x40-0x7F commands.
+*/
+uint8_t ssd1306_emu_start_line(void);
+
+/**
+ * @brief   Whether scrolling has been activated with 0x2F.
+*/
+int ssd1306_emu_scrolling(void);
+
+/**
+ * @brief   Whether the panel is on (0xAF).
+*/
+int ssd1306_emu_display_on(void);
+
+/**
+ * @brief   The pixel shown at (x, y) of the panel, taking the start line
+ *          and display offset into account. Horizontal scrolling is not
+ *          applied, it depends on time.
+ * 
+ * @return  1 if the pixel is lit
+*/
+int ssd1306_emu_pixel(int x, int y);
+
+/**
+ * @brief   Writes what the panel shows as a binary PBM (P4) image.
+ * 
+ * @return  0, or -1 if writing failed
+*/
+int ssd1306_emu_write_pbm(FILE *f);
+
+#endif /* HOST_SSD1306_EMU_HEADER */
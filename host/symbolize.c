@@ -0,0 +1,175 @@
+/**
+ * host/symbolize.c
+ * Turns the histogram of the sampling profiler, see sampler.h, into the
+ * time spent per function. The symbols are read from the output of nm:
+ *
+ *      $(TARGET)nm -n outfile.elf | host/symbolize samples.txt
+ *
+ * or `make symbolize SAMPLES=samples.txt`. A function owns the addresses
+ * from its symbol up to the next one, and a bucket that spans several
+ * functions is shared out by how many of its bytes each one has.
+ *
+ *      host/symbolize [-n functions] samples
+*/
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* --------------------------------------------- */
+/* ---------------- Definitions ---------------- */
+
+#define MAX_SYMBOLS 8192
+#define MAX_NAME 128
+#define DEFAULT_FUNCTIONS 25
+
+struct symbol
+{
+    unsigned long address;
+    char name[MAX_NAME];
+    double samples;
+};
+
+/* --------------------------------------------- */
+/* -------------- Local variables -------------- */
+
+static struct symbol symbols[MAX_SYMBOLS];
+static int symbol_count;
+
+/* --------------------------------------------- */
+/* -------------- Local functions -------------- */
+
+/* Reads the code symbols from nm's output, sorted by address */
+static void read_symbols(FILE *f);
+/* Shares the samples of [start, end) among the functions there, returns
+   the part that fell outside of every function */
+static double add_samples(unsigned long start, unsigned long end, double samples);
+static int by_address(const void *a, const void *b);
+static int by_samples(const void *a, const void *b);
+
+/* ---------------------------------------------- */
+/* ------------ Function definitions ------------ */
+
+int main(int argc, char **argv)
+{
+    FILE *f;
+    char line[256];
+    unsigned long bucket = 0, address, count, other = 0;
+    double total = 0, unknown = 0;
+    int functions = DEFAULT_FUNCTIONS;
+    int opt, i;
+
+    while ((opt = getopt(argc, argv, "n:")) != -1)
+    {
+        if (opt != 'n')
+        {
+            fprintf(stderr, "usage: nm -n outfile.elf | %s [-n functions] samples\n", argv[0]);
+            return 1;
+        }
+        functions = atoi(optarg);
+    }
+    if (optind != argc - 1)
+    {
+        fprintf(stderr, "usage: nm -n outfile.elf | %s [-n functions] samples\n", argv[0]);
+        return 1;
+    }
+
+    read_symbols(stdin);
+    if (!symbol_count)
+    {
+        fprintf(stderr, "no code symbols on stdin, pipe in the output of nm\n");
+        return 1;
+    }
+
+    f = fopen(argv[optind], "r");
+    if (!f)
+    {
+        perror(argv[optind]);
+        return 1;
+    }
+    while (fgets(line, sizeof(line), f))
+    {
+        if (sscanf(line, "bucket %lu", &bucket) == 1 || sscanf(line, "other %lu", &other) == 1)
+            continue;
+        if (sscanf(line, "%lx %lu", &address, &count) != 2)
+            continue;
+        if (!bucket)
+        {
+            fprintf(stderr, "%s: samples before the bucket size\n", argv[optind]);
+            return 1;
+        }
+        total += count;
+        unknown += add_samples(address, address + bucket, count);
+    }
+    fclose(f);
+
+    if (total + other == 0)
+    {
+        printf("no samples\n");
+        return 0;
+    }
+    total += other;
+
+    qsort(symbols, symbol_count, sizeof(symbols[0]), by_samples);
+    printf("%.0f samples, %lu outside of program flash, %.0f outside of any function\n",
+           total, other, unknown);
+    printf("     %%    samples  function\n");
+    for (i = 0; i < symbol_count && i < functions && symbols[i].samples > 0; i++)
+        printf("%6.2f %10.1f  %s\n", 100 * symbols[i].samples / total, symbols[i].samples, symbols[i].name);
+    return 0;
+}
+
+static void read_symbols(FILE *f)
+{
+    char line[256], name[MAX_NAME];
+    unsigned long address;
+    char type;
+
+    while (fgets(line, sizeof(line), f) && symbol_count < MAX_SYMBOLS)
+    {
+        // Undefined symbols have no address and don't match
+        if (sscanf(line, "%lx %c %127s", &address, &type, name) != 3)
+            continue;
+        if (type != 'T' && type != 't' && type != 'W' && type != 'w')
+            continue;
+        symbols[symbol_count].address = address;
+        strcpy(symbols[symbol_count].name, name);
+        symbol_count++;
+    }
+    qsort(symbols, symbol_count, sizeof(symbols[0]), by_address);
+}
+
+static double add_samples(unsigned long start, unsigned long end, double samples)
+{
+    double per_byte = samples / (end - start);
+    unsigned long from, to;
+    int i;
+
+    for (i = 0; i < symbol_count; i++)
+    {
+        // The last function is taken to run to the end of the bucket
+        from = symbols[i].address;
+        to = i + 1 < symbol_count ? symbols[i + 1].address : end;
+        if (from < start)
+            from = start;
+        if (to > end)
+            to = end;
+        if (from >= to)
+            continue;
+        symbols[i].samples += per_byte * (to - from);
+        samples -= per_byte * (to - from);
+    }
+    return samples;
+}
+
+static int by_address(const void *a, const void *b)
+{
+    const struct symbol *x = a, *y = b;
+    return x->address < y->address ? -1 : x->address > y->address;
+}
+
+static int by_samples(const void *a, const void *b)
+{
+    const struct symbol *x = a, *y = b;
+    return x->samples < y->samples ? 1 : x->samples > y->samples ? -1 : 0;
+}
@@ -0,0 +1,259 @@
+/**
+ * host/telemetry_decode.c
+ * Reads the telemetry the board streams over its USB serial port, see
+ * telemetry.h, and prints a line per record:
+ *
+ *      host/telemetry_decode [-b baud] [-s samples] device
+ *
+ * The device can be the serial port, a pseudo-terminal standing in for
+ * it, a file or - for stdin. A serial port or terminal is put in raw mode
+ * at the baud rate first. With -s the histogram of the sampling profiler
+ * is kept up to date in the samples file, for host/symbolize.
+ *
+ * Bytes that don't make a record with the right checksum are skipped
+ * until the next sync byte.
+*/
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#include "telemetry.h"
+#include "profile.h"
+#include "sampler.h"
+
+/* --------------------------------------------- */
+/* ---------------- Definitions ---------------- */
+
+#define MAX_BUCKETS 0x10000
+
+/* --------------------------------------------- */
+/* -------------- Local variables -------------- */
+
+static const char *samples_path;
+static uint32_t buckets[MAX_BUCKETS];
+static uint32_t samples_other;
+static uint8_t samples_shift = SAMPLER_BUCKET_SHIFT;
+static unsigned long bad_records;
+/* The last TICK record, the load is worked out between two */
+static int have_tick;
+static uint32_t tick_count, tick_interrupts, tick_cycles;
+
+/* --------------------------------------------- */
+/* -------------- Local functions -------------- */
+
+/* Puts a terminal in raw mode at baud, returns -1 if the rate isn't known */
+static int set_raw(int fd, long baud);
+/* Prints a record */
+static void decode(uint8_t type, const uint8_t *p, uint8_t length);
+/* Writes the histogram in the format of sampler.h */
+static void write_samples(void);
+static uint16_t get16(const uint8_t *p);
+static uint32_t get32(const uint8_t *p);
+
+/* ---------------------------------------------- */
+/* ------------ Function definitions ------------ */
+
+int main(int argc, char **argv)
+{
+    uint8_t record[3 + 255 + 1];
+    long baud = TELEMETRY_BAUD;
+    int have = 0, need;
+    int fd, opt, i;
+    uint8_t sum, byte;
+
+    while ((opt = getopt(argc, argv, "b:s:")) != -1)
+    {
+        switch (opt)
+        {
+        case 'b':
+            baud = atol(optarg);
+            break;
+        case 's':
+            samples_path = optarg;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-b baud] [-s samples] device\n", argv[0]);
+            return 1;
+        }
+    }
+    if (optind != argc - 1)
+    {
+        fprintf(stderr, "usage: %s [-b baud] [-s samples] device\n", argv[0]);
+        return 1;
+    }
+
+    fd = strcmp(argv[optind], "-") ? open(argv[optind], O_RDONLY | O_NOCTTY) : 0;
+    if (fd < 0)
+    {
+        perror(argv[optind]);
+        return 1;
+    }
+    if (isatty(fd) && set_raw(fd, baud) < 0)
+    {
+        fprintf(stderr, "can't set %s to %ld baud\n", argv[optind], baud);
+        return 1;
+    }
+
+    while (read(fd, &byte, 1) == 1)
+    {
+        // Look for the start of a record
+        if (have == 0 && byte != TELEMETRY_SYNC)
+            continue;
+        record[have++] = byte;
+
+        while (have >= 3 && have >= (need = 3 + record[2] + 1))
+        {
+            sum = 0;
+            for (i = 1; i < need - 1; i++)
+                sum += record[i];
+            if (sum == record[need - 1])
+                decode(record[1], record + 3, record[2]);
+            else
+            {
+                // Start over from the next sync byte after this one
+                bad_records++;
+                need = 1;
+            }
+            for (i = need; i < have && record[i] != TELEMETRY_SYNC; i++)
+                ;
+            memmove(record, record + i, have - i);
+            have -= i;
+        }
+        fflush(stdout);
+    }
+
+    if (bad_records)
+        fprintf(stderr, "%lu bad records\n", bad_records);
+    return 0;
+}
+
+static int set_raw(int fd, long baud)
+{
+    struct termios t;
+    speed_t speed;
+
+    switch (baud)
+    {
+    case 9600: speed = B9600; break;
+    case 19200: speed = B19200; break;
+    case 38400: speed = B38400; break;
+    case 57600: speed = B57600; break;
+    case 115200: speed = B115200; break;
+    case 230400: speed = B230400; break;
+    default: return -1;
+    }
+
+    if (tcgetattr(fd, &t) < 0)
+        return -1;
+    cfmakeraw(&t);
+    cfsetispeed(&t, speed);
+    cfsetospeed(&t, speed);
+    t.c_cflag |= CLOCAL | CREAD;
+    t.c_cc[VMIN] = 1;
+    t.c_cc[VTIME] = 0;
+    return tcsetattr(fd, TCSANOW, &t);
+}
+
+static void decode(uint8_t type, const uint8_t *p, uint8_t length)
+{
+    uint32_t ticks, interrupts, cycles;
+    int i;
+
+    switch (type)
+    {
+    case TELEMETRY_FRAME:
+        if (length < 15)
+            break;
+        printf("frame %u  %u us  %u bytes  state %u  dropped %u\n",
+               get32(p), get32(p + 4), get16(p + 8), p[10], get32(p + 11));
+        return;
+    case TELEMETRY_SCORE:
+        if (length < 2)
+            break;
+        printf("score %u %u\n", p[0], p[1]);
+        return;
+    case TELEMETRY_AI:
+        if (length < 6)
+            break;
+        printf("ai  y %.2f  direction %.2f  ball %.2f\n", (int16_t)get16(p) / 256.0,
+               (int16_t)get16(p + 2) / 256.0, (int16_t)get16(p + 4) / 256.0);
+        return;
+    case TELEMETRY_PROFILE:
+        if (length < 17 || p[0] >= PROFILE_SECTIONS)
+            break;
+        printf("profile %-8s %u calls  min %.2f  mean %.2f  max %.2f us\n", profile_names[p[0]],
+               get32(p + 1), (double)get32(p + 5) / CP0_TICKS_PER_US,
+               (double)get32(p + 13) / CP0_TICKS_PER_US, (double)get32(p + 9) / CP0_TICKS_PER_US);
+        if (p[0] == PROFILE_TEXT)
+            printf("text     %u cycles/glyph mean, %u min, %u max\n", get32(p + 13) * CP0_CYCLES_PER_TICK,
+                   get32(p + 5) * CP0_CYCLES_PER_TICK, get32(p + 9) * CP0_CYCLES_PER_TICK);
+        return;
+    case TELEMETRY_SAMPLES:
+        if (length < 9)
+            break;
+        samples_other = get32(p + 4);
+        samples_shift = p[8];
+        for (i = 9; i + 4 <= length; i += 4)
+            buckets[get16(p + i)] = get16(p + i + 2);
+        printf("samples %u  other %u  %d buckets\n", get32(p), samples_other, (length - 9) / 4);
+        if (samples_path)
+            write_samples();
+        return;
+    case TELEMETRY_BOOT:
+        if (length < 6)
+            break;
+        printf("boot %u/%u  %8.3f ms  %.*s\n", p[0] + 1, p[1], get32(p + 2) / 1000.0,
+               length - 6, (const char *)p + 6);
+        return;
+    case TELEMETRY_TICK:
+        if (length < 13)
+            break;
+        if (have_tick && get32(p) != tick_count && get32(p + 4) != tick_interrupts)
+        {
+            ticks = get32(p) - tick_count;
+            interrupts = get32(p + 4) - tick_interrupts;
+            cycles = get32(p + 8) - tick_cycles;
+            printf("tick%s  %.0f interrupts/s  %.1f cycles each  %.2f%% of the CPU\n",
+                   p[12] ? " (10 us legacy)" : "", (double)interrupts * CP0_COUNT_HZ / ticks,
+                   (double)cycles * CP0_CYCLES_PER_TICK / interrupts, 100.0 * cycles / ticks);
+        }
+        have_tick = 1;
+        tick_count = get32(p);
+        tick_interrupts = get32(p + 4);
+        tick_cycles = get32(p + 8);
+        return;
+    }
+    printf("record type %u, %u bytes\n", type, length);
+}
+
+static void write_samples(void)
+{
+    FILE *f = fopen(samples_path, "w");
+    int i;
+
+    if (!f)
+    {
+        perror(samples_path);
+        exit(1);
+    }
+    fprintf(f, "bucket %u\nother %u\n", 1u << samples_shift, samples_other);
+    for (i = 0; i < MAX_BUCKETS; i++)
+    {
+        if (buckets[i])
+            fprintf(f, "%08lx %u\n", SAMPLER_FLASH_BASE + ((unsigned long)i << samples_shift), buckets[i]);
+    }
+    fclose(f);
+}
+
+static uint16_t get16(const uint8_t *p)
+{
+    return p[0] | p[1] << 8;
+}
+
+static uint32_t get32(const uint8_t *p)
+{
+    return get16(p) | (uint32_t)get16(p + 2) << 16;
+}
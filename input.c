@@ -0,0 +1,113 @@
+/**
+ * input.c
+ * Buttons and switches as events, see input.h.
+*/
+#include <pic32mx.h>
+#include "input.h"
+#include "controller.h"
+#include "tick.h"
+
+/* --------------------------------------------- */
+/* ---------------- Definitions ---------------- */
+
+#define INPUT_COUNT 8
+#define QUEUE_MASK (INPUT_QUEUE_SIZE - 1)
+
+/* Keeps the compiler from moving the event's stores past the index that
+   hands it over */
+#define BARRIER() __asm__ volatile("" ::: "memory")
+
+/* --------------------------------------------- */
+/* -------------- Local variables -------------- */
+
+static volatile uint8_t state;            // Debounced
+static uint32_t changed_at[INPUT_COUNT];  // tick_us() of the last change
+
+/* The queue has one writer, the interrupt, and one reader, the main loop.
+   Each moves only its own index, so neither has to lock out the other. */
+static struct input_event queue[INPUT_QUEUE_SIZE];
+static volatile uint8_t queue_head; // Next slot written
+static volatile uint8_t queue_tail; // Next slot read
+static volatile uint32_t dropped;
+
+/* --------------------------------------------- */
+/* -------------- Local functions -------------- */
+
+static void input_push(uint8_t input, uint8_t type, uint32_t us);
+
+/* ---------------------------------------------- */
+/* ------------ Function definitions ------------ */
+
+void input_init(void)
+{
+    state = get_buttons() | get_switches() << 4;
+
+    T3CON = 0x0;
+    T3CONSET = 0x6 << 4; // Prescaling 1:64
+    TMR3 = 0x0;
+    PR3 = TICK_TIMER_HZ / INPUT_SAMPLE_RATE - 1;
+    IFSCLR(0) = INPUT_IRQ;
+    IECSET(0) = INPUT_IRQ;
+    T3CONSET = 0x8000; // start timer
+}
+
+bool input_poll(struct input_event *event)
+{
+    uint8_t tail = queue_tail;
+
+    if (tail == queue_head)
+        return false;
+    BARRIER();
+    *event = queue[tail];
+    BARRIER();
+    queue_tail = (tail + 1) & QUEUE_MASK;
+    return true;
+}
+
+uint8_t input_state(void)
+{
+    return state;
+}
+
+uint32_t input_dropped(void)
+{
+    return dropped;
+}
+
+void input_isr(void)
+{
+    uint32_t now = tick_us();
+    uint8_t sample, changed;
+    uint8_t i;
+
+    IFSCLR(0) = INPUT_IRQ;
+
+    sample = get_buttons() | get_switches() << 4;
+    changed = sample ^ state;
+    for (i = 0; changed; i++, changed >>= 1)
+    {
+        // Still bouncing from the last change
+        if (!(changed & 1) || now - changed_at[i] < INPUT_DEBOUNCE_US)
+            continue;
+        changed_at[i] = now;
+        state ^= 1 << i;
+        input_push(1 << i, sample & (1 << i) ? INPUT_PRESS : INPUT_RELEASE, now);
+    }
+}
+
+static void input_push(uint8_t input, uint8_t type, uint32_t us)
+{
+    uint8_t head = queue_head;
+    uint8_t next = (head + 1) & QUEUE_MASK;
+
+    if (next == queue_tail)
+    {
+        dropped++;
+        return;
+    }
+    queue[head].input = input;
+    queue[head].type = type;
+    queue[head].us = us;
+    BARRIER();
+    queue_head = next;
+}
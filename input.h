@@ -0,0 +1,92 @@
+/**
+ * input.h
+ *
+ * Buttons and switches as events. Timer 3 samples them 1000 times a
+ * second, so a press shorter than a frame isn't lost, and every change is
+ * queued as a press or release with the time it happened. The main loop
+ * takes the events with input_poll().
+ *
+ * A change is taken as soon as it's seen and the input is then ignored
+ * for INPUT_DEBOUNCE_US while the contacts bounce, so debouncing adds no
+ * delay to a press.
+*/
+#ifndef INPUT_HEADER
+#define INPUT_HEADER
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* --------------------------------------------- */
+/* ---------------- Definitions ---------------- */
+
+/* Inputs, as bits like get_buttons() and get_switches() << 4 */
+#define INPUT_BTN1 0x01
+#define INPUT_BTN2 0x02
+#define INPUT_BTN3 0x04
+#define INPUT_BTN4 0x08
+#define INPUT_SW1 0x10
+#define INPUT_SW2 0x20
+#define INPUT_SW3 0x40
+#define INPUT_SW4 0x80
+#define INPUT_BUTTONS 0x0F
+#define INPUT_SWITCHES 0xF0
+
+/* Event types */
+#define INPUT_PRESS 1   // Button pressed or switch turned on
+#define INPUT_RELEASE 0
+
+#define INPUT_SAMPLE_RATE 1000
+#define INPUT_DEBOUNCE_US 5000
+/* Events the queue holds, a power of two */
+#define INPUT_QUEUE_SIZE 32
+
+/* Timer 3 interrupt, bit in IFS(0)/IEC(0), and its priority: above the
+   frame tick so the time stamps don't wait for it */
+#define INPUT_IRQ (1 << 12)
+#define INPUT_PRIORITY 5
+
+/* --------------------------------------------- */
+/* ----------- Variable declarations ----------- */
+
+/**
+ * @brief   A button or switch changing.
+*/
+struct input_event
+{
+    uint8_t input; // INPUT_BTN1 etc.
+    uint8_t type;  // INPUT_PRESS or INPUT_RELEASE
+    uint32_t us;   // When it changed, see tick_us()
+};
+
+/* --------------------------------------------- */
+/* ----------- Function declarations ----------- */
+
+/**
+ * @brief   Starts sampling with Timer 3. The interrupt is installed
+ *          separately, see interrupt.h.
+*/
+void input_init(void);
+
+/**
+ * @brief   Takes the oldest event off the queue.
+ *
+ * @return  false if there was none
+*/
+bool input_poll(struct input_event *event);
+
+/**
+ * @return  the debounced state of the inputs, INPUT_* bits
+*/
+uint8_t input_state(void);
+
+/**
+ * @return  events lost because the queue was full
+*/
+uint32_t input_dropped(void);
+
+/**
+ * @brief   Timer 3 interrupt handler.
+*/
+void input_isr(void);
+
+#endif /* INPUT_HEADER */
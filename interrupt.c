@@ -0,0 +1,66 @@
+/**
+ * interrupt.c
+ * Multi-vector interrupts, see interrupt.h and vectors.S.
+*/
+#include <pic32mx.h>
+#include "interrupt.h"
+#include "main.h"
+
+/* --------------------------------------------- */
+/* ---------------- Definitions ---------------- */
+
+/* Configuration word 3, FSRSSEL is bits 2:0 */
+#define DEVCFG3_ADDRESS 0xBFC02FF0
+#define FSRSSEL_MASK 0x7
+/* FSRSSEL 0 gives every priority the shadow register set */
+#define FSRSSEL_ALL 0x0
+
+#define INTCON_MVEC (1 << 12)
+
+/* --------------------------------------------- */
+/* -------------- Local variables -------------- */
+
+/* In vectors.S */
+extern void *_isr_primary_install[INTERRUPT_VECTORS];
+extern void (*_isr_handlers[INTERRUPT_VECTORS])(void);
+extern volatile uint32_t _isr_cycles;
+extern void _isr_trampoline(void);
+extern void _isr_shadow(void);
+
+static uint8_t shadow_priority;
+static uint8_t priorities[INTERRUPT_VECTORS];
+
+/* ---------------------------------------------- */
+/* ------------ Function definitions ------------ */
+
+void interrupt_init(void)
+{
+    shadow_priority = *(volatile const uint32_t *)DEVCFG3_ADDRESS & FSRSSEL_MASK;
+    INTCONSET = INTCON_MVEC;
+}
+
+void interrupt_install(uint8_t vector, uint8_t priority, void (*handler)(void))
+{
+    uint8_t shift = 8 * (vector % 4) + 2;
+
+    // Each IPC register holds the priorities of four vectors. The vector
+    // is off while its entry and priority may not match.
+    IPCCLR(vector / 4) = 0x7 << shift;
+
+    priorities[vector] = priority & 0x7;
+    _isr_handlers[vector] = handler ? handler : user_isr;
+    _isr_primary_install[vector] = interrupt_shadowed(vector) ? _isr_shadow : _isr_trampoline;
+
+    IPCSET(vector / 4) = priorities[vector] << shift;
+}
+
+bool interrupt_shadowed(uint8_t vector)
+{
+    return priorities[vector] &&
+           (shadow_priority == FSRSSEL_ALL || priorities[vector] == shadow_priority);
+}
+
+uint32_t interrupt_get_cycles(void)
+{
+    return _isr_cycles;
+}
@@ -0,0 +1,68 @@
+/**
+ * interrupt.h
+ *
+ * Multi-vector interrupts. Every vector has its own entry in vectors.S,
+ * which calls the handler installed for it, so a handler only runs for
+ * its own source instead of user_isr() checking every flag. Vectors
+ * without a handler still go to user_isr().
+ *
+ * The handler of the priority that DEVCFG3 FSRSSEL gives the shadow
+ * register set (7 from the bootloader) is entered without saving any
+ * registers, give that priority to the source that can wait the least.
+*/
+#ifndef INTERRUPT_HEADER
+#define INTERRUPT_HEADER
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* --------------------------------------------- */
+/* ---------------- Definitions ---------------- */
+
+#define INTERRUPT_VECTORS 64
+
+/* Vector numbers, see the PIC32MX3XX/4XX datasheet's interrupt table */
+#define VECTOR_CORE_TIMER 0
+#define VECTOR_TIMER2 8
+#define VECTOR_TIMER3 12
+#define VECTOR_TIMER4 16
+#define VECTOR_TIMER5 20
+#define VECTOR_UART1 24
+#define VECTOR_I2C1 25
+#define VECTOR_CHANGE_NOTICE 26
+#define VECTOR_SPI2 31
+
+/* --------------------------------------------- */
+/* ----------- Function declarations ----------- */
+
+/**
+ * @brief   Switches the interrupt controller to multi-vector mode. Call
+ *          before enable_interrupt().
+*/
+void interrupt_init(void);
+
+/**
+ * @brief   Makes a vector call handler and sets its priority. The source's
+ *          own interrupt enable bit is left alone.
+ *
+ * @param vector    VECTOR_*
+ * @param priority  1-7, 0 turns the vector off
+ * @param handler   called with interrupts disabled, NULL for user_isr()
+*/
+void interrupt_install(uint8_t vector, uint8_t priority, void (*handler)(void));
+
+/**
+ * @return  whether the vector is entered on the shadow register set
+*/
+bool interrupt_shadowed(uint8_t vector);
+
+/**
+ * @brief   Time spent in interrupt handlers, counted by vectors.S around
+ *          every handler call. The few instructions of the entry and exit
+ *          outside of that aren't counted.
+ *
+ * @return  CP0 Count ticks since boot, wraps around; take differences
+*/
+uint32_t interrupt_get_cycles(void);
+
+#endif /* INTERRUPT_HEADER */
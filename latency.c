@@ -0,0 +1,104 @@
+/**
+ * latency.c
+ * Button-to-photon latency, see latency.h.
+*/
+#include <string.h>
+#include <stdbool.h>
+#include "latency.h"
+#include "display.h"
+#include "tick.h"
+#include "cp0.h"
+
+/* --------------------------------------------- */
+/* -------------- Local variables -------------- */
+
+static struct latency_stats stats = {.min_us = UINT32_MAX};
+
+/* The press being measured */
+static bool pressed;
+static bool applied;
+static uint32_t press_us;
+static uint32_t applied_count; // CP0 Count when the game acted on it
+static uint8_t first_page, last_page;
+
+/* --------------------------------------------- */
+/* -------------- Local functions -------------- */
+
+static void latency_record(uint32_t us);
+
+/* ---------------------------------------------- */
+/* ------------ Function definitions ------------ */
+
+void latency_press(uint32_t us)
+{
+    if (pressed)
+        return;
+    pressed = true;
+    applied = false;
+    press_us = us;
+}
+
+void latency_applied(uint8_t page0, uint8_t page1)
+{
+    if (!pressed || applied)
+        return;
+    applied = true;
+    applied_count = cp0_get_count();
+    first_page = page0 < DISPLAY_ROW_SETS ? page0 : DISPLAY_ROW_SETS - 1;
+    last_page = page1 < DISPLAY_ROW_SETS ? page1 : DISPLAY_ROW_SETS - 1;
+}
+
+void latency_poll(void)
+{
+    uint32_t sent;
+    uint8_t j;
+
+    if (!pressed)
+        return;
+
+    if (applied)
+    {
+        // The first of the pages sent since the game acted on the press
+        for (j = first_page; j <= last_page; j++)
+        {
+            sent = display_get_page_sent(j);
+            if ((int32_t)(sent - applied_count) > 0)
+            {
+                latency_record(tick_count_to_us(sent) - press_us);
+                pressed = false;
+                return;
+            }
+        }
+    }
+
+    if (tick_us() - press_us > LATENCY_TIMEOUT_US)
+    {
+        stats.timeouts++;
+        pressed = false;
+    }
+}
+
+void latency_get_stats(struct latency_stats *out)
+{
+    *out = stats;
+}
+
+void latency_reset(void)
+{
+    memset(&stats, 0, sizeof(stats));
+    stats.min_us = UINT32_MAX;
+    pressed = false;
+}
+
+static void latency_record(uint32_t us)
+{
+    uint32_t bucket = us / LATENCY_BUCKET_US;
+
+    stats.count++;
+    stats.total_us += us;
+    if (us < stats.min_us)
+        stats.min_us = us;
+    if (us > stats.max_us)
+        stats.max_us = us;
+    stats.histogram[bucket < LATENCY_BUCKETS ? bucket : LATENCY_BUCKETS - 1]++;
+}
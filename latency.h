@@ -0,0 +1,79 @@
+/**
+ * latency.h
+ *
+ * Button-to-photon latency: the time from a button press, as stamped by
+ * input.c, until the display has been sent the page that shows what the
+ * press changed. One press is followed at a time:
+ *
+ *      latency_press()     a press that will change the screen
+ *      latency_applied()   the game has acted on it, the change is in
+ *                          these pages of the frame being drawn
+ *      latency_poll()      every frame, finishes the measurement once
+ *                          one of those pages has been sent
+*/
+#ifndef LATENCY_HEADER
+#define LATENCY_HEADER
+
+#include <stdint.h>
+
+/* --------------------------------------------- */
+/* ---------------- Definitions ---------------- */
+
+/* Histogram of 2 ms buckets, the last one holds everything longer */
+#define LATENCY_BUCKETS 32
+#define LATENCY_BUCKET_US 2000
+/* A press whose change never shows, e.g. a paddle already at the wall,
+   is given up after this long */
+#define LATENCY_TIMEOUT_US 250000
+
+/* --------------------------------------------- */
+/* ----------- Variable declarations ----------- */
+
+/**
+ * @brief   The measured latencies, see latency_get_stats().
+*/
+struct latency_stats
+{
+    uint32_t count;
+    uint32_t timeouts;
+    uint32_t min_us;
+    uint32_t max_us;
+    uint32_t total_us; // Sum, for the mean
+    uint16_t histogram[LATENCY_BUCKETS];
+};
+
+/* --------------------------------------------- */
+/* ----------- Function declarations ----------- */
+
+/**
+ * @brief   Starts a measurement unless one is already running.
+ *
+ * @param us    when the button was pressed, see tick_us()
+*/
+void latency_press(uint32_t us);
+
+/**
+ * @brief   The press being measured has changed frame pages
+ *          [page0, page1]. Only the first call after latency_press()
+ *          counts.
+*/
+void latency_applied(uint8_t page0, uint8_t page1);
+
+/**
+ * @brief   Finishes the measurement if the change has reached the display,
+ *          call once a frame.
+*/
+void latency_poll(void);
+
+/**
+ * @brief   Copies the statistics.
+*/
+void latency_get_stats(struct latency_stats *stats);
+
+/**
+ * @brief   Clears the statistics, e.g. before comparing two ways of
+ *          sampling the input.
+*/
+void latency_reset(void);
+
+#endif /* LATENCY_HEADER */
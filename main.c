@@ -14,306 +14,133 @@
 /* --------------------------------------------- */
 /* -------------- Local varaibles -------------- */
 
-static int timeout_counter; //
-static int timeout_flag;
-static int button_state;
+static uint8_t buttons_pressed; // Buttons pressed since the last frame
+static uint8_t buttons_held;    // Buttons down now
+static uint32_t press_us;       // When the first of buttons_pressed was pressed
 static int switch_state;
-
-const currentState STATE_TABLE[5] =
+static struct swtimer letter_repeat; // Steps through letters while a button is held
+static char highscore_log[SCOREBOARD_ENTRIES][SCORE_STR_SIZE + 1];   // array to display
+static uint8_t record[SCOREBOARD_ENTRIES][SCORE_RECORD_SIZE]; // array to store record info
+
+/* Set-up run while the display powers up, see boot.h */
+static void start_tick(void);
+static void start_interrupts(void);
+static void start_sampler(void);
+static void start_telemetry(void);
+/* Queues this frame's telemetry records */
+static void send_telemetry(uint32_t frame_us);
+/* What deadline_end() counts the frame in: the game by its mode, GAME_PVP
+   or GAME_PVM, the other screens by their state */
+static uint8_t deadline_state(void);
+static void build_highscores(void);
+/* Buttons that step the letter in the name entry this frame */
+static uint8_t letter_steps(void);
+/* Takes the queued input events, adding to buttons_pressed */
+static void take_input(void);
+/* Moves the paddles of the human players */
+static void move_paddles(float dt);
+
+static const struct boot_job BOOT_JOBS[] =
+    {
+        {"tick", start_tick},
+        {"input", input_init},
+        {"interrupts", start_interrupts},
+        {"sampler", start_sampler},
+        {"telemetry", start_telemetry},
+        {"sprites", render_init},
+        {"highscores", build_highscores}};
+
+/* States, see states.h. The views are what each screen is drawn from */
+static struct
+{
+    uint8_t selected; // MENU until a choice is made
+} menu_view;
+static struct
+{
+    int16_t p1_y, p2_y;
+    int16_t ball_x, ball_y;
+    int16_t score1, score2;
+} game_view;
+static struct
+{
+    uint8_t record[SCORE_RECORD_SIZE + 1]; // The name, the score and a '\0'
+    uint8_t letters;                       // Letters chosen so far
+} name_view;
+static int current_letter; // Shown at name_view.letters
+static int score_cp;       // Highscore entry at the top of the screen
+/* The simulation clock: how far it has got, in frames, and the time left
+   over from the last frame, in 1/(PHYSICS_RATE * frame rate) s */
+static uint32_t physics_frame;
+static uint32_t physics_time;
+
+static void menu_enter(void);
+static uint8_t menu_update(void);
+static void menu_render(void);
+static void menu_exit(void);
+static void start_enter(void);
+static uint8_t start_update(void);
+static void game_enter(void);
+static uint8_t game_update(void);
+static void game_render(void);
+static uint8_t paused_update(void);
+static void paused_render(void);
+static void paused_exit(void);
+static uint8_t game_over_update(void);
+static void game_over_render(void);
+static void name_enter(void);
+static uint8_t name_update(void);
+static void name_render(void);
+static void scoreboard_enter(void);
+static uint8_t scoreboard_update(void);
+static void scoreboard_exit(void);
+
+static const struct state STATES[STATE_COUNT] =
     {
-        MENU,
-        GAME_PVP,
-        GAME_PVM,
-        SCOREBOARD,
-        ACCEPT};
+        [MENU] = {"menu", menu_enter, menu_update, menu_render, menu_exit, &menu_view, sizeof(menu_view)},
+        [GAME_PVP] = {"start", start_enter, start_update, NULL, NULL, NULL, 0},
+        [GAME_PVM] = {"start", start_enter, start_update, NULL, NULL, NULL, 0},
+        [SCOREBOARD] = {"scoreboard", scoreboard_enter, scoreboard_update, NULL, scoreboard_exit, NULL, 0},
+        [PLAYING] = {"game", game_enter, game_update, game_render, NULL, &game_view, sizeof(game_view)},
+        [PAUSED] = {"paused", NULL, paused_update, paused_render, paused_exit, NULL, 0},
+        [GAME_OVER] = {"game over", NULL, game_over_update, game_over_render, NULL, NULL, 0},
+        [NAME_ENTRY] = {"name", name_enter, name_update, name_render, NULL, &name_view, sizeof(name_view)}};
 
 /* --------------------------------------------- */
 /* ----------------- Main loop ----------------- */
 
 int main()
 {
-    initialize_system();
-    /* Display */
-    display_init();
-
-    /* Init */
-    initialize_timer();
-    enable_interrupt();
-
-    currentState current_state = MENU;
-    currentState selected_state = MENU;
-    bool new_game = true;
-    bool game_on = false;
-    bool checking_highscores = false;
-    int score_cp = 0;
-    char highscore_log[SCOREBOARD_ENTRIES][SCORE_STR_SIZE + 1];   // array to display
-    static uint8_t record[SCOREBOARD_ENTRIES][SCORE_RECORD_SIZE]; // array to store record info
-
-    /* Main loop */
+    /* Everything else is set up while the display powers up */
+    boot_run(initialize_system, BOOT_JOBS, sizeof(BOOT_JOBS) / sizeof(BOOT_JOBS[0]));
+    display_stream_asset(&asset_splash, 0, 0);
+    boot_mark("first frame");
+#if TELEMETRY
+    telemetry_boot();
+#endif
+
+    /* The splash screen stays up while the CPU sleeps */
+    static struct swtimer splash;
+    uint32_t frame_us = 0;
+    swtimer_start(&splash, SPLASH_MS, 0, NULL);
+    while (swtimer_running(&splash))
+        tick_wait();
+
+    /* Main loop, the screens are the states in STATES */
+    states_start(STATES, MENU);
     while (1)
     {
-        while (!timeout_flag)
-        {
-        };
-        timeout_flag = 0;
-
-        button_state = get_buttons();
-        switch_state = get_switches();
-
-        /* If we aren't in a game, meaning we are in the menu... */
-        if (!game_on && !checking_highscores)
-        {
-            display_clear_screen();
-
-            if (button_state & 0x1) // button 1
-            {
-                selected_state = GAME_PVP;
-                quicksleep(10000);
-            }
-            else if (button_state & 0x2) // button 2
-            {
-                selected_state = GAME_PVM;
-                quicksleep(10000);
-            }
-            else if (button_state & 0x4) // button 3
-            {
-                selected_state = SCOREBOARD;
-                quicksleep(10000);
-            }
-            else if (button_state & 0x8) // button 4
-            {
-                if (selected_state != MENU)
-                {
-                    current_state = STATE_TABLE[selected_state];
-                    selected_state = ACCEPT;
-                }
-                quicksleep(10000);
-            }
-
-            display_print_text("Menu:         ", 0, 0);
-            switch (STATE_TABLE[selected_state])
-            {
-            case GAME_PVP:
-                display_print_text("P1 vs. P2     ", 0, 8);
-                break;
-            case GAME_PVM:
-                display_print_text("Player vs. AI ", 0, 8);
-                break;
-            case SCOREBOARD:
-                display_print_text("Show highscore", 0, 8);
-                break;
-            case ACCEPT:
-            {
-                if (current_state == GAME_PVP || current_state == GAME_PVM)
-                    game_on = true;
-                else if (current_state == SCOREBOARD)
-                    checking_highscores = true;
-                break;
-            }
-            default:
-                display_print_text("Press Btn1/2/3", 0, 8);
-                break;
-            }
-            display_update();
-        }
-
-        /* When the game is playing */
-        else if (game_on && !checking_highscores)
-        {
-
-            /* NEW GAME */
-            if (new_game)
-            {
-                pong_initialize_game(&player1, &player2, &the_ball, current_state);
-                new_game = false;
-            }
-
-            /* GAME RUNNING */
-            if (((player1.score == WIN_SCORE || player2.score == WIN_SCORE) && !player1.is_ai) || (player1.is_ai && player1.score == WIN_SCORE)) /* If a player wins... */
-            {
-                display_draw_filled_rect(SCREEN_OFFSET, 1, 127 - SCREEN_OFFSET - 1, 30, 0);
-                display_draw_filled_rect(0, 7, 127, 24, 0);
-                // Print winner
-                if (player1.score == WIN_SCORE)
-                {
-                    if (player1.is_ai)
-                        display_print_text(" The A.I. wins ", 4, 7);
-                    else
-                        display_print_text(" Player 1 wins ", 4, 7);
-                }
-                else
-                {
-                    if (player2.is_ai)
-                        display_print_text(" The A.I. wins ", 4, 7);
-                    else
-                        display_print_text(" Player 2 wins ", 4, 7);
-                }
-                display_print_text(" Btn1 to quit ", 4, 16);
-
-                if (button_state & 0x1) // We want to exit the game and go back to main menu
-                {
-                    // Reset game parameters
-                    game_on = false;
-                    current_state = MENU;
-                    selected_state = MENU;
-                    new_game = true;
-                    // record match score
-                    if (player1.is_ai)
-                    {
-                        uint8_t new_record[4] = {0x32, 0x32, 0x32, player2.score};
-                        int c = 0;
-                        int current_letter = 0x2E; // This is a dot '.'
-                        do
-                        {
-                            display_clear_screen();
-                            button_state = get_buttons();
-                            display_print_text("Name:        ", 1, 7);
-                            display_print_text((char *)new_record, 4, 16);
-                            display_draw_filled_rect(10 + c*8, 15, 128, 31, 0);
-                            new_record[c] = current_letter;
-                            if (button_state & 0x2)
-                            {
-                                current_letter++;
-                                quicksleep(20000);
-                                if (current_letter > 0x5A || current_letter < 0x41)
-                                    current_letter = 0x41;
-                            }
-                            else if (button_state & 0x4)
-                            {
-                                current_letter--;
-                                quicksleep(20000);
-                                if (current_letter < 0x41)
-                                    current_letter = 0x5A;
-                            }
-                            else if (button_state & 0x8 && current_letter != 0x2E)
-                            {
-                                c += 1;
-                                current_letter = 0x2E;
-                                quicksleep(5000);
-                            }
-                            display_update();
-                        } while (c < 3);
-
-                        score_append_new_record(record, new_record);
-                        score_convert_to_strings(highscore_log, record);
-                    }
-                    pong_set_score(&player1, 0);
-                    pong_set_score(&player2, 0);
-
-                    if (player1.is_ai)
-                        pong_ai_reset(&player1);
-                    if (player2.is_ai)
-                        pong_ai_reset(&player2);
-                }
-                display_update();
-                quicksleep(1000);
-            }
-            else if (switch_state & 0x1) /* PAUSED STATE */
-            {
-                display_draw_filled_rect(12, 7, 12 + (8 * 13), 24, 0);
-                display_print_text(" Game Paused  ", 4, 7);
-                display_print_text(" Btn1 to quit ", 4, 16);
-                display_update();
-                quicksleep(1000);
-                if (button_state & 0x1)
-                {
-                    game_on = false;
-                    current_state = MENU;
-                    selected_state = MENU;
-                    new_game = true;
-                }
-            }
-            /* ----------------Game loop---------------- */
-            else
-            {
-                // If player1 isn't an ai, take input
-                if (!(player1.is_ai))
-                {
-                    if (button_state & 0x1) // button 1
-                    {
-                        if (player1.y + P_HEIGHT < 31)
-                            pong_move_paddle(&player1, 1.f, 1.f);
-                    }
-                    if (button_state & 0x2) // button 2
-                    {
-                        if (player1.y > 1.f)
-                            pong_move_paddle(&player1, -1.f, 1.f);
-                    }
-                }
-                // Skynet activate
-                else
-                {
-                    pong_ai_run(&player1, &the_ball, switch_state);
-                }
-                // If player2 isn't an ai, take input
-                if (!(player2.is_ai))
-                {
-                    if (button_state & 0x4) // button 3
-                    {
-                        if (player2.y + P_HEIGHT < 31)
-                            pong_move_paddle(&player2, 1.f, 1.f);
-                    }
-                    if (button_state & 0x8) // button 4
-                    {
-                        if (player2.y > 1.f)
-                            pong_move_paddle(&player2, -1.f, 1.f);
-                    }
-                }
-                // Skynet activate
-                else
-                {
-                    pong_ai_run(&player2, &the_ball, switch_state);
-                }
-
-                // Update ball position
-                pong_move_ball(&player1, &player2, &the_ball, 1.f);
-
-                // Rendering
-                display_clear_screen();
-
-                char score_str[SCORE_STR_SIZE+1];
-                // This is not the way text should be handled, but it works so it's fine
-                display_print_text("P2            P1", 0, 7);
-                score_convert_to_string(score_str, player2.score, player1.score);
-                display_print_text(score_str, 0, 16);
-                score_str[0] = '\0';
-
-                display_draw_empty_rect(SCREEN_OFFSET - 1, 0, 127 - SCREEN_OFFSET, 31, 1);
-                display_draw_filled_rect(SCREEN_OFFSET, 1, 127 - SCREEN_OFFSET - 1, 30, 0);
-                display_draw_filled_rect((int)player1.x, (int)player1.y, (int)(player1.x + P_WIDTH), (int)(player1.y + P_HEIGHT), 1);
-                display_draw_filled_rect((int)player2.x, (int)player2.y, (int)(player2.x + P_WIDTH), (int)(player2.y + P_HEIGHT), 1);
-                display_draw_filled_rect((int)the_ball.x, (int)the_ball.y, (int)the_ball.x + B_WIDTH, (int)the_ball.y + B_HEIGHT, 1);
-                display_update();
-            }
-        }
-        else if (!game_on && checking_highscores)
-        {
-            if (button_state & 0x1) // button 1
-            {
-                checking_highscores = false;
-                current_state = MENU;
-                selected_state = SCOREBOARD;
-                quicksleep(2000);
-                display_clear_screen();
-            }
-            if ((button_state & 0x2) && score_cp > 0) // button 2
-            {
-                score_cp -= 1;
-            }
-            if ((button_state & 0x4) && score_cp < SCOREBOARD_ENTRIES - 2) // button 3
-            {
-                score_cp += 1;
-            }
-            display_clear_screen();
-            display_print_text("Name: Scr:   B1>", 0, 0);
-            if (record[score_cp][0] != 0 || record[score_cp][1] != 0 || record[score_cp][2] != 0 || record[score_cp][3] != 0)
-                display_print_text(highscore_log[score_cp], 0, 7);
-            if (record[score_cp + 1][0] != 0 || record[score_cp + 1][1] != 0 || record[score_cp + 1][2] != 0 || record[score_cp + 1][3] != 0)
-                display_print_text(highscore_log[score_cp + 1], 0, 15);
-            if (record[score_cp + 2][0] != 0 || record[score_cp + 2][1] != 0 || record[score_cp + 2][2] != 0 || record[score_cp + 2][3] != 0)
-                display_print_text(highscore_log[score_cp + 2], 0, 23);
-            display_update();
-        }
+        deadline_begin(tick_wait());
+        latency_poll();
+
+        read_input();
+        states_update();
+        // Under load the game keeps updating but fewer frames are drawn
+        if (deadline_render_ok())
+            states_render();
+        // The last frame's time, so that it took in its own records
+        send_telemetry(frame_us);
+        overlay_frame(frame_us);
+        frame_us = deadline_end(deadline_state());
     }
     int i;
     for (i = SCOREBOARD_ENTRIES - 1; i > 0; i--)
@@ -357,39 +184,517 @@ void initialize_system()
 
     /* Set up SPI as master */
     SPI2CON = 0;
-    SPI2BRG = 4;
-    SPI2STATCLR = 0x40;  /* SPI2STAT bit SPIROV = 0; */
-    SPI2CONSET = 0x40;   /* SPI2CON bit CKP = 1; */
-    SPI2CONSET = 0x20;   /* SPI2CON bit MSTEN = 1; */
-    SPI2CONSET = 0x8000; /* SPI2CON bit ON = 1; */
+    SPI2BRG = DISPLAY_SPI_BRG;
+    SPI2STATCLR = 0x40;   /* SPI2STAT bit SPIROV = 0; */
+    SPI2CONSET = 0x40;    /* SPI2CON bit CKP = 1; */
+    SPI2CONSET = 0x20;    /* SPI2CON bit MSTEN = 1; */
+    SPI2CONSET = 0x10000; /* SPI2CON bit ENHBUF = 1, 16 byte FIFOs */
+    SPI2CONSET = 0x8000;  /* SPI2CON bit ON = 1; */
+}
+
+static void start_tick(void)
+{
+    tick_init(FRAME_RATE);
 }
 
-void initialize_timer()
+static void start_interrupts(void)
 {
-    T2CONCLR = 0xFFFF; // Clear Timer 2
-    TMR2 = 0x0;        // Set timer value 0
+    /* Every source straight to its own handler */
+    interrupt_init();
+    interrupt_install(VECTOR_TIMER2, TICK_PRIORITY, tick_isr);
+    interrupt_install(VECTOR_TIMER3, INPUT_PRIORITY, input_isr);
+    interrupt_install(VECTOR_TIMER4, SAMPLER_PRIORITY, sampler_isr);
+    interrupt_install(VECTOR_UART1, TELEMETRY_PRIORITY, telemetry_isr);
+    interrupt_install(VECTOR_SPI2, DISPLAY_SPI_PRIORITY, display_spi_isr);
+    enable_interrupt();
+}
 
-    T2CONSET = 0x4 << 4; // Prescaling 1:16
-    PR2 = TMR2PERIOD;    // period
+static void start_sampler(void)
+{
+#if SAMPLE_RATE
+    sampler_start(SAMPLE_RATE);
+#endif
+}
 
-    T2CONSET = 0x1 << 15; // start timer
+static void start_telemetry(void)
+{
+#if TELEMETRY
+    telemetry_init(TELEMETRY_BAUD);
+#endif
+}
 
-    IPC(2) = 0x4;         // priority 4
-    IECSET(0) = 0x1 << 8; // Enable interrupt
-    IFSCLR(0) = 0x1 << 8; // Clear interrupt flag
+static uint8_t deadline_state(void)
+{
+    if (states_current() == PLAYING)
+        return player1.is_ai ? GAME_PVM : GAME_PVP;
+    return states_current();
 }
 
-void user_isr()
+static void send_telemetry(uint32_t frame_us)
+{
+#if TELEMETRY
+    static uint8_t sent_score1 = 0xFF, sent_score2 = 0xFF;
+    static uint32_t tick_sent;
+#if PROFILE
+    static uint8_t section;
+#endif
+    float direction, predicted_y;
+
+    telemetry_frame(tick_frames(), frame_us, display_get_bytes_sent(), states_current());
+    if (states_current() == PLAYING)
+    {
+        if (player1.score != sent_score1 || player2.score != sent_score2)
+        {
+            sent_score1 = player1.score;
+            sent_score2 = player2.score;
+            telemetry_score(sent_score1, sent_score2);
+        }
+        if (player1.is_ai)
+        {
+            pong_ai_get_decision(&direction, &predicted_y);
+            telemetry_ai(player1.y, direction, predicted_y);
+        }
+    }
+
+    // The profiles a section at a time, the samples a record at a time
+#if PROFILE
+    telemetry_profile(section);
+    section = (section + 1) % PROFILE_SECTIONS;
+#endif
+    telemetry_samples();
+    // The tick's interrupt load once a second
+    if (tick_frames() - tick_sent >= tick_get_rate())
+    {
+        tick_sent = tick_frames();
+        telemetry_tick();
+    }
+#endif
+}
+
+static void build_highscores(void)
+{
+    score_convert_to_strings(highscore_log, record);
+}
+
+/* ---------------- Menu ---------------- */
+
+static void menu_enter(void)
+{
+    // The menu lives at the top of the display memory
+    display_set_page_base(0);
+}
+
+static uint8_t menu_update(void)
+{
+    // Slide back to the menu from wherever the last screen left the start line
+    if (display_move_start_line(0, SCROLL_STEP) && MENU_GREYSCALE && !display_grey_enabled())
+    {
+        // Not before, the start line can't be moved while subframes are sent
+        set_greyscale(true);
+        states_redraw();
+    }
+
+    if (buttons_pressed & INPUT_BTN1) // button 1
+        menu_view.selected = GAME_PVP;
+    else if (buttons_pressed & INPUT_BTN2) // button 2
+        menu_view.selected = GAME_PVM;
+    else if (buttons_pressed & INPUT_BTN3) // button 3
+        menu_view.selected = SCOREBOARD;
+    else if ((buttons_pressed & INPUT_BTN4) && menu_view.selected != MENU) // button 4
+        return menu_view.selected;
+    return STATE_SAME;
+}
+
+static void menu_render(void)
+{
+    display_clear_screen();
+    display_print_text("Menu:         ", 0, 0);
+    switch (menu_view.selected)
+    {
+    case GAME_PVP:
+        display_print_text("P1 vs. P2     ", 0, 8);
+        break;
+    case GAME_PVM:
+        display_print_text("Player vs. AI ", 0, 8);
+        break;
+    case SCOREBOARD:
+        display_print_text("Show highscore", 0, 8);
+        break;
+    default:
+        display_print_text("Press Btn1/2/3", 0, 8);
+        break;
+    }
+
+    if (!display_grey_enabled())
+    {
+        display_update();
+        return;
+    }
+    // The last picture hasn't been picked up yet, draw again next frame
+    if (display_grey_presenting())
+    {
+        states_redraw();
+        return;
+    }
+    display_grey_clear();
+    display_grey_fill_rect(0, 8, DISPLAY_WIDTH - 1, 15, GREY_DARK);
+    display_grey_draw_screen(GREY_WHITE);
+    display_grey_present();
+}
+
+static void menu_exit(void)
+{
+    // The other screens are drawn in black and white
+    if (display_grey_enabled())
+        set_greyscale(false);
+}
+
+/* ---------------- Game ---------------- */
+
+static void start_enter(void)
+{
+    // GAME_PVP or GAME_PVM, the mode pong_initialize_game() takes
+    pong_initialize_game(&player1, &player2, &the_ball, states_current());
+    pong_set_score(&player1, 0);
+    pong_set_score(&player2, 0);
+    if (player1.is_ai)
+        pong_ai_reset(&player1);
+    if (player2.is_ai)
+        pong_ai_reset(&player2);
+    menu_view.selected = MENU;
+
+    // Draw the game below the menu in the display memory and slide it into view
+    display_set_page_base(GAME_PAGE_BASE);
+    render_invalidate();
+    render_game(&player1, &player2, &the_ball);
+    display_update();
+}
+
+static uint8_t start_update(void)
+{
+    if (display_move_start_line(GAME_PAGE_BASE * DISPLAY_ROW_BITS, SCROLL_STEP))
+        return PLAYING;
+    return STATE_SAME;
+}
+
+static void game_enter(void)
+{
+    // The time spent before the game, or paused, isn't simulated
+    physics_frame = tick_frames();
+    physics_time = 0;
+}
+
+static uint8_t game_update(void)
+{
+    uint32_t frame = tick_frames();
+    uint16_t rate = tick_get_rate();
+    uint8_t steps, i;
+
+    if (((player1.score == WIN_SCORE || player2.score == WIN_SCORE) && !player1.is_ai) || (player1.is_ai && player1.score == WIN_SCORE)) /* If a player wins... */
+        return GAME_OVER;
+    if (switch_state & 0x1)
+        return PAUSED;
+
+    // Counted in 1/(PHYSICS_RATE * rate) s, a frame is PHYSICS_RATE of
+    // those and a step is rate
+    physics_time += (frame - physics_frame) * PHYSICS_RATE;
+    physics_frame = frame;
+    steps = 0;
+    while (physics_time >= rate && steps < PHYSICS_MAX_STEPS)
+    {
+        physics_time -= rate;
+        steps++;
+    }
+    // Too far behind to catch up
+    if (physics_time >= rate)
+        physics_time %= rate;
+
+#if !LATE_INPUT
+    move_paddles(steps * PHYSICS_DT);
+#endif
+    for (i = 0; i < steps; i++)
+    {
+        // Skynet activate
+        PROFILE_BEGIN(PROFILE_AI);
+        if (player1.is_ai)
+            pong_ai_run(&player1, &the_ball, switch_state, PHYSICS_DT);
+        if (player2.is_ai)
+            pong_ai_run(&player2, &the_ball, switch_state, PHYSICS_DT);
+        PROFILE_END(PROFILE_AI);
+
+        // Update ball position
+        PROFILE_BEGIN(PROFILE_PHYSICS);
+        pong_move_ball(&player1, &player2, &the_ball, PHYSICS_DT);
+        PROFILE_END(PROFILE_PHYSICS);
+    }
+
+#if LATE_INPUT
+    // The buttons are read again right before the frame is drawn,
+    // so presses during the game update still make this frame. The
+    // paddles move for the whole frame at once
+    take_input();
+    move_paddles(steps * PHYSICS_DT);
+#endif
+
+    // As render_game() draws them
+    game_view.p1_y = (int)player1.y;
+    game_view.p2_y = (int)player2.y;
+    game_view.ball_x = (int)the_ball.x;
+    game_view.ball_y = (int)the_ball.y;
+    game_view.score1 = player1.score;
+    game_view.score2 = player2.score;
+    return STATE_SAME;
+}
+
+static void game_render(void)
+{
+    // Only the moving objects are drawn unless the background changed
+    PROFILE_BEGIN(PROFILE_RENDER);
+    render_game(&player1, &player2, &the_ball);
+    PROFILE_END(PROFILE_RENDER);
+    // SW2 shows the performance overlay
+    overlay_draw(switch_state & 0x2);
+    // Send the frame in the background, the next one is built while it's sent
+    PROFILE_BEGIN(PROFILE_FLUSH);
+    display_update_async();
+    PROFILE_END(PROFILE_FLUSH);
+}
+
+static uint8_t paused_update(void)
+{
+    if (buttons_pressed & INPUT_BTN1)
+        return MENU;
+    if (!(switch_state & 0x1))
+        return PLAYING;
+    return STATE_SAME;
+}
+
+static void paused_render(void)
+{
+    display_draw_filled_rect(12, 7, 12 + (8 * 13), 24, 0);
+    display_print_text(" Game Paused  ", 4, 7);
+    display_print_text(" Btn1 to quit ", 4, 16);
+    display_update();
+}
+
+static void paused_exit(void)
+{
+    // The banner is drawn over the game, build it again when resuming
+    render_invalidate();
+}
+
+static uint8_t game_over_update(void)
+{
+    if (!(buttons_pressed & INPUT_BTN1)) // Btn1 goes back to the main menu
+        return STATE_SAME;
+    // Against the AI the score goes on the highscore list
+    return player1.is_ai ? NAME_ENTRY : MENU;
+}
+
+static void game_over_render(void)
+{
+    display_draw_filled_rect(SCREEN_OFFSET, 1, 127 - SCREEN_OFFSET - 1, 30, 0);
+    display_draw_filled_rect(0, 7, 127, 24, 0);
+    // Print winner
+    if (player1.score == WIN_SCORE)
+    {
+        if (player1.is_ai)
+            display_print_text(" The A.I. wins ", 4, 7);
+        else
+            display_print_text(" Player 1 wins ", 4, 7);
+    }
+    else
+    {
+        if (player2.is_ai)
+            display_print_text(" The A.I. wins ", 4, 7);
+        else
+            display_print_text(" Player 2 wins ", 4, 7);
+    }
+    display_print_text(" Btn1 to quit ", 4, 16);
+    display_update();
+}
+
+/* ---------------- Name entry ---------------- */
+
+static void name_enter(void)
+{
+    memset(name_view.record, 0x32, SCORE_RECORD_SIZE - 1);
+    name_view.record[SCORE_RECORD_SIZE - 1] = player2.score;
+    name_view.record[SCORE_RECORD_SIZE] = '\0';
+    name_view.letters = 0;
+    current_letter = 0x2E; // This is a dot '.'
+}
+
+static uint8_t name_update(void)
+{
+    uint8_t steps = letter_steps();
+
+    name_view.record[name_view.letters] = current_letter;
+    if (steps & INPUT_BTN2)
+    {
+        current_letter++;
+        if (current_letter > 0x5A || current_letter < 0x41)
+            current_letter = 0x41;
+    }
+    else if (steps & INPUT_BTN3)
+    {
+        current_letter--;
+        if (current_letter < 0x41)
+            current_letter = 0x5A;
+    }
+    else if (buttons_pressed & INPUT_BTN4 && current_letter != 0x2E)
+    {
+        name_view.letters += 1;
+        current_letter = 0x2E;
+    }
+
+    if (name_view.letters < SCORE_RECORD_SIZE - 1)
+        return STATE_SAME;
+    score_append_new_record(record, name_view.record);
+    score_convert_to_strings(highscore_log, record);
+    return MENU;
+}
+
+static void name_render(void)
+{
+    display_clear_screen();
+    display_print_text("Name:        ", 1, 7);
+    display_print_text((char *)name_view.record, 4, 16);
+    display_draw_filled_rect(10 + name_view.letters * 8, 15, 128, 31, 0);
+    display_update();
+}
+
+/* ---------------- Highscores ---------------- */
+
+static void scoreboard_enter(void)
+{
+    // The whole list is drawn once and scrolled with the start line
+    render_highscores(record, highscore_log);
+}
+
+static uint8_t scoreboard_update(void)
+{
+    if (buttons_pressed & INPUT_BTN1) // button 1
+        return MENU;
+    if ((buttons_pressed & INPUT_BTN2) && score_cp > 0) // button 2
+        score_cp -= 1;
+    // The last view is pages 4 to 7, start lines further down wrap the
+    // header on page 0 around to the bottom
+    if ((buttons_pressed & INPUT_BTN3) && score_cp < DISPLAY_MEMORY_PAGES - DISPLAY_ROW_SETS) // button 3
+        score_cp += 1;
+    display_move_start_line(score_cp * DISPLAY_ROW_BITS, SCROLL_STEP);
+    return STATE_SAME;
+}
+
+static void scoreboard_exit(void)
+{
+    display_clear_screen();
+}
+
+void read_input(void)
+{
+    buttons_pressed = 0;
+    take_input();
+}
+
+static void take_input(void)
+{
+    struct input_event event;
+    PROFILE_BEGIN(PROFILE_INPUT);
+
+    while (input_poll(&event))
+    {
+        if (event.type != INPUT_PRESS || !(event.input & INPUT_BUTTONS))
+            continue;
+        if (!buttons_pressed)
+            press_us = event.us;
+        buttons_pressed |= event.input;
+    }
+    buttons_held = input_state() & INPUT_BUTTONS;
+    switch_state = input_state() >> 4;
+    PROFILE_END(PROFILE_INPUT);
+}
+
+static void move_paddles(float dt)
 {
-    if (IFS(0) & (1 << 8))
+    // A press shorter than a frame still moves the paddle once
+    uint8_t moving = buttons_held | buttons_pressed;
+    struct paddle *moved = NULL;
+
+    // If player1 isn't an ai, take input
+    if (!(player1.is_ai))
     {
-        timeout_counter++;
-        if (timeout_counter >= 3333)
+        if (moving & INPUT_BTN1) // button 1
+        {
+            if (player1.y + P_HEIGHT < 31)
+                pong_move_paddle(&player1, 1.f, dt);
+        }
+        if (moving & INPUT_BTN2) // button 2
+        {
+            if (player1.y > 1.f)
+                pong_move_paddle(&player1, -1.f, dt);
+        }
+        if (buttons_pressed & (INPUT_BTN1 | INPUT_BTN2))
+            moved = &player1;
+    }
+    // If player2 isn't an ai, take input
+    if (!(player2.is_ai))
+    {
+        if (moving & INPUT_BTN3) // button 3
+        {
+            if (player2.y + P_HEIGHT < 31)
+                pong_move_paddle(&player2, 1.f, dt);
+        }
+        if (moving & INPUT_BTN4) // button 4
         {
-            timeout_flag = 1;    // sets the flag
-            timeout_counter = 0; // reset counter
+            if (player2.y > 1.f)
+                pong_move_paddle(&player2, -1.f, dt);
         }
-        // Reset the interrupt flag
-        IFSCLR(0) = 1 << 8;
+        if (!moved && (buttons_pressed & (INPUT_BTN3 | INPUT_BTN4)))
+            moved = &player2;
+    }
+
+    // Time how long the press takes to show: the paddle's rows, and the
+    // one on either side it moved out of, are drawn in this frame
+    if (moved)
+    {
+        latency_press(press_us);
+        latency_applied((moved->y > 1.f ? (int)moved->y - 1 : 0) / DISPLAY_ROW_BITS,
+                        (int)(moved->y + P_HEIGHT + 1) / DISPLAY_ROW_BITS);
+    }
+}
+
+static uint8_t letter_steps(void)
+{
+    // Once per press, then every LETTER_REPEAT_MS while it's held
+    if (buttons_pressed & (INPUT_BTN2 | INPUT_BTN3))
+    {
+        swtimer_start(&letter_repeat, LETTER_DELAY_MS, LETTER_REPEAT_MS, NULL);
+        return buttons_pressed;
+    }
+    if (!(buttons_held & (INPUT_BTN2 | INPUT_BTN3)))
+    {
+        swtimer_stop(&letter_repeat);
+        return 0;
+    }
+    return swtimer_fired(&letter_repeat) ? buttons_held : 0;
+}
+
+void set_greyscale(bool on)
+{
+    display_grey_enable(on);
+    // Subframes have to be sent at a steady rate, whatever the frame rate
+    tick_set_subtick(on ? DISPLAY_GREY_SUBFRAME_RATE : 0, on ? display_grey_tick : NULL);
+}
+
+void user_isr()
+{
+    if (IFS(0) & TICK_IRQ)
+    {
+        tick_isr();
+    }
+    if ((IFS(1) & DISPLAY_SPI2TX_IRQ) && (IEC(1) & DISPLAY_SPI2TX_IRQ))
+    {
+        display_spi_isr();
     }
 }
\ No newline at end of file
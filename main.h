@@ -20,17 +20,62 @@
 #include "pong.h"
 #include "pong_ai.h"
 #include "score.h"
+#include "render.h"
+#include "assets.h"
+#include "tick.h"
+#include "interrupt.h"
+#include "swtimer.h"
+#include "boot.h"
+#include "input.h"
+#include "latency.h"
+#include "states.h"
+#include "deadline.h"
+#include "profile.h"
+#include "sampler.h"
+#include "telemetry.h"
+#include "overlay.h"
 
 /* --------------------------------------------- */
 /* ---------------- Definitions ---------------- */
 
-#define CLOCKFREQ 80000000    // 80 MHz
-#define TIMEOUTPERIOD 0.00001 // 10 us
-#define TMR2PRESCALER 16      // 5 MHz
-#define TMR2PERIOD ((CLOCKFREQ / TMR2PRESCALER) * TIMEOUTPERIOD)
+#define FRAME_RATE 30 // Hz, see tick.h
+
+/* 1 to read the buttons again after the game update, right before the
+   frame is drawn, instead of only at the start of the frame. Compare the
+   two with latency_get_stats(). */
+#define LATE_INPUT 1
+
+/* The game is simulated in fixed steps of 1/PHYSICS_RATE s, however often
+   frames are drawn. A frame takes at most PHYSICS_MAX_STEPS to catch up,
+   after a longer stall the game slows down rather than jumping ahead */
+#define PHYSICS_RATE 120
+#define PHYSICS_MAX_STEPS 8
+#define PHYSICS_DT ((float)PONG_DT_RATE / PHYSICS_RATE)
+
+/* Samples a second of the sampling profiler, see sampler.h, 0 to leave
+   it off */
+#define SAMPLE_RATE SAMPLER_DEFAULT_RATE
+
+/* 1 to stream telemetry over UART1, see telemetry.h */
+#define TELEMETRY 1
+
+/* 1 to show the menu in greyscale once it has slid into view, the choice
+   on a dark grey bar, see set_greyscale(). Off by default: the tick runs
+   at DISPLAY_GREY_SUBFRAME_RATE and SPI2 sends subframes for as long as
+   the menu is shown. */
+#define MENU_GREYSCALE 0
 
 #define WIN_SCORE 3
 
+/* The game is drawn in the half of the display memory below the menu and
+   slid into view by moving the start line SCROLL_STEP lines per tick */
+#define GAME_PAGE_BASE 4
+#define SCROLL_STEP 4
+/* Timings in ms, see swtimer.h */
+#define SPLASH_MS 1000     // How long the splash screen is shown at start
+#define LETTER_DELAY_MS 400  // A held button starts stepping through letters after this
+#define LETTER_REPEAT_MS 150 // ...and then steps at this rate
+
 /* -------------------------------------------- */
 /* ------- Extern variable declarations ------- */
 
@@ -43,13 +88,19 @@ extern const int SCREEN_OFFSET;
 /* --------------------------------------------- */
 /* ----------- Variable declarations ----------- */
 
+/* The states of the game, see states.h. GAME_PVP and GAME_PVM start a
+   game in that mode, see pong_initialize_game() */
 typedef enum Game_state
 {
     MENU = 0,
     GAME_PVP = 1,
     GAME_PVM = 2,
     SCOREBOARD = 3,
-    ACCEPT = 4
+    PLAYING = 4,
+    PAUSED = 5,
+    GAME_OVER = 6,
+    NAME_ENTRY = 7,
+    STATE_COUNT
 } currentState;
 
 /* --------------------------------------------- */
@@ -70,18 +121,26 @@ void enable_interrupt();
 */
 void initialize_system();
 
-/** 
- * @author  Alex Lindberg
- * @author  Lucas Larsson
- * @brief   Initializes timer.
- *          This function was written as part of Lab3, course IS1200. 
+/**
+ * @brief   Takes this frame's input events: the buttons pressed since the
+ *          last call, the buttons held down and the switches.
+*/
+void read_input(void);
+
+/**
+ * @brief   Turns the display's greyscale mode on or off, and with it the
+ *          subframes sent from the tick interrupt. Use this instead of
+ *          display_grey_enable(). The menu turns it on, see
+ *          MENU_GREYSCALE, and off again when it is left.
 */
-void initialize_timer();
+void set_greyscale(bool on);
 
 /** 
  * @author  Alex Lindberg
  * @author  Lucas Larsson
  * @brief   Interrupt handling routing.
  *          This function was written as part of Lab3, course IS1200. 
+ *          Only called for vectors without a handler of their own, see
+ *          interrupt.h.
 */
 void user_isr();
\ No newline at end of file
@@ -0,0 +1,164 @@
+/**
+ * overlay.c
+ * Performance overlay in the margins of the game screen, see overlay.h.
+*/
+#include "overlay.h"
+#include "display.h"
+#include "assets.h"
+#include "interrupt.h"
+#include "profile.h"
+#include "tick.h"
+#include "cp0.h"
+
+/* --------------------------------------------- */
+/* ---------------- Definitions ---------------- */
+
+/* Glyphs of assets/minifont.pbm, 3 columns each. A field is 4 glyphs with
+   a blank column between them, just wide enough for a 15 pixel margin. */
+#define GLYPH_WIDTH 3
+#define GLYPH_HEIGHT 5
+#define GLYPH_PERCENT 10
+#define GLYPH_K 11
+#define GLYPH_SPACE 12
+#define FIELD_GLYPHS 4
+#define FIELD_WIDTH (FIELD_GLYPHS * (GLYPH_WIDTH + 1) - 1)
+
+#define FIELD_FPS 0
+#define FIELD_FRAME_US 1
+#define FIELD_BYTES 2
+#define FIELD_ISR 3
+#define FIELDS 4
+
+/* Top left corner of each field, clear of the border at x 15 and 111 and
+   of the labels and scores in rows 7 to 23 */
+static const uint8_t FIELD_X[FIELDS] = {0, 0, 113, 113};
+static const uint8_t FIELD_Y[FIELDS] = {1, 25, 1, 25};
+
+/* --------------------------------------------- */
+/* -------------- Local variables -------------- */
+
+/* Counted since the numbers were last worked out */
+static uint32_t interval_us;
+static uint32_t interval_cycles;
+static uint32_t worst_us;
+static uint32_t renders;
+static uint32_t bytes_total;
+
+/* The numbers, and the fields drawn from them */
+static uint16_t values[FIELDS];
+static uint8_t suffixes[FIELDS] = {GLYPH_SPACE, GLYPH_SPACE, GLYPH_SPACE, GLYPH_PERCENT};
+static uint32_t columns[FIELDS][FIELD_WIDTH];
+static bool stale = true; // values changed since columns were drawn
+static bool shown;
+
+static const uint32_t blank[FIELD_WIDTH];
+
+/* --------------------------------------------- */
+/* -------------- Local functions -------------- */
+
+/* Draws a number right-aligned into a field's columns, followed by the
+   suffix glyph unless that is a space */
+static void overlay_format(uint8_t field, uint16_t value, uint8_t suffix);
+
+/* ---------------------------------------------- */
+/* ------------ Function definitions ------------ */
+
+void overlay_frame(uint32_t frame_us)
+{
+    uint32_t now = tick_us();
+    uint32_t elapsed = now - interval_us;
+    uint32_t cycles;
+
+    if (frame_us > worst_us)
+        worst_us = frame_us;
+    if (elapsed < OVERLAY_UPDATE_MS * 1000)
+        return;
+
+    cycles = interrupt_get_cycles();
+    values[FIELD_FPS] = (renders * 1000000 + elapsed / 2) / elapsed;
+    values[FIELD_BYTES] = renders ? bytes_total / renders : 0;
+    values[FIELD_ISR] = (cycles - interval_cycles) / (elapsed / 100 * CP0_TICKS_PER_US);
+
+    // Longer frames in thousands, so they still fit the field
+    if (worst_us < 10000)
+    {
+        values[FIELD_FRAME_US] = worst_us;
+        suffixes[FIELD_FRAME_US] = GLYPH_SPACE;
+    }
+    else
+    {
+        values[FIELD_FRAME_US] = worst_us < 1000000 ? worst_us / 1000 : 999;
+        suffixes[FIELD_FRAME_US] = GLYPH_K;
+    }
+    if (values[FIELD_BYTES] > 9999)
+        values[FIELD_BYTES] = 9999;
+
+    interval_us = now;
+    interval_cycles = cycles;
+    worst_us = 0;
+    renders = 0;
+    bytes_total = 0;
+    stale = true;
+}
+
+void overlay_draw(bool on)
+{
+    uint8_t i;
+
+    // The flush of the last frame drawn
+    renders++;
+    bytes_total += display_get_bytes_sent();
+
+    if (!on)
+    {
+        if (!shown)
+            return;
+        for (i = 0; i < FIELDS; i++)
+            display_put_columns(blank, FIELD_X[i], FIELD_WIDTH,
+                                ((1 << GLYPH_HEIGHT) - 1) << FIELD_Y[i]);
+        shown = false;
+        return;
+    }
+
+    PROFILE_BEGIN(PROFILE_OVERLAY);
+    if (stale)
+    {
+        for (i = 0; i < FIELDS; i++)
+            overlay_format(i, values[i], suffixes[i]);
+        stale = false;
+    }
+    for (i = 0; i < FIELDS; i++)
+        display_put_columns(columns[i], FIELD_X[i], FIELD_WIDTH,
+                            ((1 << GLYPH_HEIGHT) - 1) << FIELD_Y[i]);
+    shown = true;
+    PROFILE_END(PROFILE_OVERLAY);
+}
+
+static void overlay_format(uint8_t field, uint16_t value, uint8_t suffix)
+{
+    uint8_t glyphs[FIELD_GLYPHS];
+    uint8_t i = FIELD_GLYPHS, col;
+    uint32_t *out = columns[field];
+
+    if (suffix != GLYPH_SPACE)
+        glyphs[--i] = suffix;
+    // Digits from the right, whatever doesn't fit is dropped
+    do
+    {
+        glyphs[--i] = value % 10;
+        value /= 10;
+    } while (value && i > 0);
+    while (i > 0)
+        glyphs[--i] = GLYPH_SPACE;
+
+    for (i = 0; i < FIELD_GLYPHS; i++)
+    {
+        for (col = 0; col < GLYPH_WIDTH; col++)
+        {
+            *out++ = glyphs[i] == GLYPH_SPACE ? 0
+                     : (uint32_t)minifont[glyphs[i] * GLYPH_WIDTH + col] << FIELD_Y[field];
+        }
+        if (i < FIELD_GLYPHS - 1)
+            *out++ = 0;
+    }
+}
@@ -0,0 +1,52 @@
+/**
+ * overlay.h
+ *
+ * Performance overlay for the game screen. Four numbers are drawn in a
+ * 3x5 font, see assets/minifont.pbm, in the margins beside the playfield
+ * above and below the player labels and scores:
+ *
+ *      top left        frames drawn per second
+ *      bottom left     longest frame in us, "12k" from 10 ms up
+ *      top right       bytes sent to the display per flush
+ *      bottom right    share of the time spent in interrupt handlers
+ *
+ * The numbers cover the last OVERLAY_UPDATE_MS and only change that
+ * often. A field is redrawn every frame, which also puts it back after
+ * the background was built again, but only columns that change are sent,
+ * so a steady overlay adds nothing to the flush.
+ *
+ *      overlay_frame()     at the end of every frame
+ *      overlay_draw()      when the game is drawn, before the flush
+*/
+#ifndef OVERLAY_HEADER
+#define OVERLAY_HEADER
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* --------------------------------------------- */
+/* ---------------- Definitions ---------------- */
+
+/* How often the numbers are worked out again */
+#define OVERLAY_UPDATE_MS 500
+
+/* --------------------------------------------- */
+/* ----------- Function declarations ----------- */
+
+/**
+ * @brief   Counts a frame of the main loop, and works out the numbers
+ *          every OVERLAY_UPDATE_MS.
+ *
+ * @param frame_us  how long the last frame took, see deadline_end()
+*/
+void overlay_frame(uint32_t frame_us);
+
+/**
+ * @brief   Counts a drawn frame and draws the overlay into it, or erases
+ *          it once after it was turned off.
+ *
+ * @param on    whether the overlay is shown
+*/
+void overlay_draw(bool on);
+
+#endif /* OVERLAY_HEADER */
@@ -140,8 +140,9 @@ void pong_move_ball(struct paddle *p1, struct paddle *p2, struct ball *b, float
         pong_set_ball_velocity(b, -(b->vx), 0.f);
         pong_increment_score(p2);
     }
-    // Bounce on the floor and ceiling
-    if (b->y <= 0.f || b->y >= 31.f)
+    // Bounce on the floor and ceiling, only when heading into them so a
+    // short step that leaves the ball past the edge doesn't bounce it back
+    if ((b->y <= 0.f && b->vy < 0.f) || (b->y >= 31.f && b->vy > 0.f))
     {
         pong_set_ball_velocity(b, b->vx, -(b->vy));
     }
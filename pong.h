@@ -24,6 +24,9 @@
 #define TO_RAD(a) (a * (M_PI / 180.0))
 /* The maximum angle of reflection in degrees */
 #define MAX_REFLECT_ANGLE 45
+/* Time is counted in 1/PONG_DT_RATE s, a dt of 1.f. The velocities are in
+   pixels per that */
+#define PONG_DT_RATE 30
 
 #define BALL_START_POS_X 63.f
 #define BALL_START_POS_Y 15.f
@@ -108,8 +111,7 @@ void pong_initialize_game(struct paddle *p1, struct paddle *p2, struct ball *b,
  * @param p1            The first player to initialize. 
  * @param p2            The second player to initialize. 
  * @param b             The ball.
- * @param dt            delta time. Left for future work.
- * @param current_mode  the selected game mode
+ * @param dt            time to move for, see PONG_DT_RATE
 */
 void pong_move_ball(struct paddle *p1, struct paddle *p2, struct ball *b, float dt);
 
@@ -127,7 +129,7 @@ void pong_set_ball_velocity(struct ball *b, float vx1, float vy1);
  * 
  * @param player    The target player to move.
  * @param vy1       The vertical velocity to set.
- * @param dt        delta time. Left for future work.
+ * @param dt        time to move for, see PONG_DT_RATE
 */
 void pong_move_paddle(struct paddle *player, float vy1, float dt);
 
@@ -19,25 +19,25 @@ static int lower_y, upper_y;
 /* ---------------------------------------------- */
 /* ------------ Function definitions ------------ */
 
-void pong_ai_run(struct paddle *ai, struct ball *b, int current_switch_state)
+void pong_ai_run(struct paddle *ai, struct ball *b, int current_switch_state, float dt)
 {
     if (current_switch_state & 0x4)
     {
-        pong_ai_normal_brain(ai, b);
+        pong_ai_normal_brain(ai, b, dt);
     }
     else if (current_switch_state & 0x8)
     {
-        pong_ai_galaxy_brain(ai, b);
+        pong_ai_galaxy_brain(ai, b, dt);
     }
     else
     {
-        pong_ai_smooth_brain(ai, b);
+        pong_ai_smooth_brain(ai, b, dt);
     }
 }
 
-void pong_ai_smooth_brain(struct paddle *ai, struct ball *b)
+void pong_ai_smooth_brain(struct paddle *ai, struct ball *b, float dt)
 {
-    pong_move_paddle(ai, current_ai_direction, 1.f);
+    pong_move_paddle(ai, current_ai_direction, dt);
     next_ai_y = ai->y + current_ai_direction;
     if (next_ai_y + P_HEIGHT > 31 || next_ai_y < 0)
         current_ai_direction *= -1.f;
@@ -59,7 +59,7 @@ static float predict_next_ball_y(float current_x, float current_y, float dx, flo
     return final_y;
 }
 
-void pong_ai_normal_brain(struct paddle *ai, struct ball *b)
+void pong_ai_normal_brain(struct paddle *ai, struct ball *b, float dt)
 {
     distance_ball_to_ai = fabs(ai->x - (b->x+B_WIDTH/2));
 
@@ -75,12 +75,12 @@ void pong_ai_normal_brain(struct paddle *ai, struct ball *b)
                 current_ai_direction = fabs(current_ai_direction) * 1.2f;
             else if( next_ball_y  < lower_y)
                 current_ai_direction = fabs(current_ai_direction) * -1.2f;
-            pong_move_paddle(ai, current_ai_direction, 1.f);
+            pong_move_paddle(ai, current_ai_direction, dt);
         }
     }
 }
 
-void pong_ai_galaxy_brain(struct paddle *ai, struct ball *b)
+void pong_ai_galaxy_brain(struct paddle *ai, struct ball *b, float dt)
 {
     lower_y = ai->y - (B_HEIGHT / 2);
     upper_y = ai->y + P_HEIGHT + (B_HEIGHT / 2);
@@ -91,10 +91,16 @@ void pong_ai_galaxy_brain(struct paddle *ai, struct ball *b)
         if (b->y + (B_HEIGHT / 2) > upper_y || b->y + (B_HEIGHT / 2) < lower_y)
             current_ai_direction *= 1.2f;
         if(!(fabs(b->y - (ai->y + (P_HEIGHT/2)) ) > (P_HEIGHT/2)))
-            pong_move_paddle(ai, current_ai_direction, 1.f);
+            pong_move_paddle(ai, current_ai_direction, dt);
     }
 }
 
+void pong_ai_get_decision(float *direction, float *predicted_y)
+{
+    *direction = current_ai_direction;
+    *predicted_y = next_ball_y;
+}
+
 void pong_ai_reset(struct paddle *ai)
 {
     pong_create_player(ai, true, 'A');
@@ -31,31 +31,43 @@ extern const int SCREEN_OFFSET;
  * @param ai                    The paddle acting as A.I.
  * @param b                     The ball
  * @param current_switch_state  A.I. intelligence
+ * @param dt                    time to move for, see PONG_DT_RATE
 */
-void pong_ai_run(struct paddle *ai, struct ball *b, int current_switch_state);
+void pong_ai_run(struct paddle *ai, struct ball *b, int current_switch_state, float dt);
+
+/**
+ * @brief   What the A.I. last decided, e.g. for telemetry.
+ *
+ * @param direction     speed it moves at, negative is up
+ * @param predicted_y   where it expects the ball, if it has looked
+*/
+void pong_ai_get_decision(float *direction, float *predicted_y);
 
 /**
  * @brief easiest AI mode. Simply moves up and down.
  * 
  * @param ai    the paddle acting as ai
  * @param b     the ball
+ * @param dt    time to move for
 */
-void pong_ai_smooth_brain(struct paddle *ai, struct ball *b);
+void pong_ai_smooth_brain(struct paddle *ai, struct ball *b, float dt);
 
 /**
  * @brief normal AI mode. Tracks ball direction and tries to bounce it.
  * 
  * @param ai    the paddle acting as ai
  * @param b     the ball
+ * @param dt    time to move for
 */
-void pong_ai_normal_brain(struct paddle *ai, struct ball *b);
+void pong_ai_normal_brain(struct paddle *ai, struct ball *b, float dt);
 
 /**
  * @brief hardest AI mode. Tracks ball movement and direction.
  * 
  * @param ai    the paddle acting as ai
  * @param b     the ball
+ * @param dt    time to move for
 */
-void pong_ai_galaxy_brain(struct paddle *ai, struct ball *b);
+void pong_ai_galaxy_brain(struct paddle *ai, struct ball *b, float dt);
 
 void pong_ai_reset(struct paddle *ai);
\ No newline at end of file
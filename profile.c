@@ -0,0 +1,45 @@
+/**
+ * profile.c
+ * Section timing, see profile.h.
+*/
+#include "profile.h"
+
+#if PROFILE
+#include <string.h>
+
+/* --------------------------------------------- */
+/* -------------- Local variables -------------- */
+
+static struct profile_stats sections[PROFILE_SECTIONS];
+
+/* ---------------------------------------------- */
+/* ------------ Function definitions ------------ */
+
+const char *const profile_names[PROFILE_SECTIONS] =
+    {"input", "ai", "physics", "hud", "render", "flush", "overlay", "text"};
+
+void profile_record(uint8_t section, uint32_t ticks)
+{
+    struct profile_stats *s = &sections[section];
+    // One more than the index of the highest bit set, a single clz
+    uint8_t bucket = ticks ? 32 - __builtin_clz(ticks) : 0;
+
+    if (!s->count || ticks < s->min)
+        s->min = ticks;
+    if (ticks > s->max)
+        s->max = ticks;
+    s->count++;
+    s->total += ticks;
+    s->histogram[bucket < PROFILE_BUCKETS ? bucket : PROFILE_BUCKETS - 1]++;
+}
+
+const struct profile_stats *profile_get(uint8_t section)
+{
+    return &sections[section];
+}
+
+void profile_reset(void)
+{
+    memset(sections, 0, sizeof(sections));
+}
+#endif
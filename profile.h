@@ -0,0 +1,96 @@
+/**
+ * profile.h
+ *
+ * A scoped profiler for the hot paths of the main loop. A section is
+ * timed by reading the CP0 Count at its start and end:
+ *
+ *      PROFILE_BEGIN(PROFILE_AI);
+ *      pong_ai_run(...);
+ *      PROFILE_END(PROFILE_AI);
+ *
+ * and each section keeps the count, min, max and total of its times in
+ * Count ticks, and a histogram of them in powers of two, in a fixed table.
+ * On a PC the Count is made from the monotonic clock, see cp0.h, so the
+ * same sections can be profiled in the host builds.
+ *
+ * With PROFILE set to 0 the macros are empty and profile.c compiles to
+ * nothing, e.g. `make CFLAGS+=-DPROFILE=0`.
+*/
+#ifndef PROFILE_HEADER
+#define PROFILE_HEADER
+
+#include <stdint.h>
+#include "cp0.h"
+
+/* --------------------------------------------- */
+/* ---------------- Definitions ---------------- */
+
+#ifndef PROFILE
+#define PROFILE 1
+#endif
+
+/* Sections */
+#define PROFILE_INPUT 0   // Taking the input events
+#define PROFILE_AI 1      // pong_ai_run()
+#define PROFILE_PHYSICS 2 // pong_move_ball()
+#define PROFILE_HUD 3     // Formatting the score
+#define PROFILE_RENDER 4  // Drawing the frame
+#define PROFILE_FLUSH 5   // Starting it on its way to the display
+#define PROFILE_OVERLAY 6 // overlay_draw()
+#define PROFILE_TEXT 7    // display_print_text(), per glyph
+#define PROFILE_SECTIONS 8
+
+/* Bucket i counts times of [2^(i-1), 2^i) ticks, bucket 0 those of 0
+   ticks and the last one everything from 2^(PROFILE_BUCKETS-2) up */
+#define PROFILE_BUCKETS 24
+
+#if PROFILE
+#define PROFILE_BEGIN(section) uint32_t profile_start_##section = cp0_get_count()
+#define PROFILE_END(section) profile_record(section, cp0_get_count() - profile_start_##section)
+#else
+#define PROFILE_BEGIN(section)
+#define PROFILE_END(section)
+#endif
+
+/* --------------------------------------------- */
+/* ----------- Variable declarations ----------- */
+
+/**
+ * @brief   The times of a section, in Count ticks, see profile_get().
+*/
+struct profile_stats
+{
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t total; // For the mean
+    uint32_t histogram[PROFILE_BUCKETS];
+};
+
+#if PROFILE
+/* Names of the sections, for printing */
+extern const char *const profile_names[PROFILE_SECTIONS];
+
+/* --------------------------------------------- */
+/* ----------- Function declarations ----------- */
+
+/**
+ * @brief   Adds a time to a section, see PROFILE_END().
+ *
+ * @param section   PROFILE_INPUT etc.
+ * @param ticks     Count ticks the section took
+*/
+void profile_record(uint8_t section, uint32_t ticks);
+
+/**
+ * @return  the times of a section
+*/
+const struct profile_stats *profile_get(uint8_t section);
+
+/**
+ * @brief   Clears every section.
+*/
+void profile_reset(void);
+#endif
+
+#endif /* PROFILE_HEADER */
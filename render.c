@@ -0,0 +1,142 @@
+/**
+ * render.c
+ * 
+ * Draws the game screen.
+*/
+#include <stddef.h>
+#include "render.h"
+#include "profile.h"
+
+/* --------------------------------------------- */
+/* ---------------- Definitions ---------------- */
+
+/* The header and the entries of the highscore list fill the display memory */
+#if SCOREBOARD_ENTRIES + 1 > DISPLAY_MEMORY_PAGES
+#error "The highscore list doesn't fit in the display memory"
+#endif
+
+/* --------------------------------------------- */
+/* -------------- Local variables -------------- */
+
+static struct display_sprite paddle_sprite;
+static struct display_sprite ball_sprite;
+
+/* Where a moving object was drawn last frame */
+struct footprint
+{
+    const struct display_sprite *sprite;
+    int x, y;
+};
+
+/* Footprints of player 1, player 2 and the ball */
+static struct footprint footprints[3];
+/* Set when the game's background has to be built again */
+static bool redraw_background = true;
+/* The scores shown in the background */
+static uint8_t drawn_score1, drawn_score2;
+
+/* --------------------------------------------- */
+/* -------------- Local functions -------------- */
+
+/* Draws the border and HUD of the game and saves it as the background */
+static void render_game_background(struct paddle *p1, struct paddle *p2);
+/* Erases the paddles and the ball where they were and draws them where they are */
+static void render_game_objects(struct paddle *p1, struct paddle *p2, struct ball *b);
+
+/* ---------------------------------------------- */
+/* ------------ Function definitions ------------ */
+
+void render_init()
+{
+    display_sprite_filled(&paddle_sprite, P_WIDTH, P_HEIGHT);
+    display_sprite_filled(&ball_sprite, B_WIDTH, B_HEIGHT);
+}
+
+void render_invalidate()
+{
+    redraw_background = true;
+}
+
+void render_game(struct paddle *p1, struct paddle *p2, struct ball *b)
+{
+    if (redraw_background || p1->score != drawn_score1 || p2->score != drawn_score2)
+        render_game_background(p1, p2);
+
+    render_game_objects(p1, p2, b);
+}
+
+static void render_game_background(struct paddle *p1, struct paddle *p2)
+{
+    char score_str[SCORE_STR_SIZE + 1];
+    int i;
+
+    display_clear_screen();
+    // This is not the way text should be handled, but it works so it's fine
+    display_print_text("P2            P1", 0, 7);
+    PROFILE_BEGIN(PROFILE_HUD);
+    score_convert_to_string(score_str, p2->score, p1->score);
+    PROFILE_END(PROFILE_HUD);
+    display_print_text(score_str, 0, 16);
+    display_draw_empty_rect(SCREEN_OFFSET - 1, 0, 127 - SCREEN_OFFSET, 31, 1);
+    display_save_background();
+
+    drawn_score1 = p1->score;
+    drawn_score2 = p2->score;
+    redraw_background = false;
+
+    // Nothing to erase, the objects are drawn on a fresh background
+    for (i = 0; i < 3; i++)
+        footprints[i].sprite = NULL;
+}
+
+static void render_game_objects(struct paddle *p1, struct paddle *p2, struct ball *b)
+{
+    const struct display_sprite *sprites[3] = {&paddle_sprite, &paddle_sprite, &ball_sprite};
+    int x[3] = {(int)p1->x, (int)p2->x, (int)b->x};
+    int y[3] = {(int)p1->y, (int)p2->y, (int)b->y};
+    struct footprint *f;
+    int i;
+
+    // Erase every object that moved before drawing any, so that an object
+    // isn't cut by the footprint of another one
+    for (i = 0; i < 3; i++)
+    {
+        f = &footprints[i];
+        if (f->sprite && (f->x != x[i] || f->y != y[i]))
+            display_restore_background(f->x, f->y, f->sprite->width, f->sprite->height);
+    }
+
+    for (i = 0; i < 3; i++)
+    {
+        display_blit(sprites[i], x[i], y[i], BLIT_SET);
+        footprints[i].sprite = sprites[i];
+        footprints[i].x = x[i];
+        footprints[i].y = y[i];
+    }
+}
+
+void render_highscores(uint8_t record[SCOREBOARD_ENTRIES][SCORE_RECORD_SIZE],
+                       char strings[SCOREBOARD_ENTRIES][SCORE_STR_SIZE + 1])
+{
+    int base, i, page;
+
+    // The half below the screen first, so the screen data ends up matching
+    // the pages that are shown
+    for (base = DISPLAY_MEMORY_PAGES - DISPLAY_ROW_SETS; base >= 0; base -= DISPLAY_ROW_SETS)
+    {
+        display_set_page_base(base);
+        display_clear_screen();
+        if (base == 0)
+            display_print_text("Name: Scr:   B1>", 0, 0);
+
+        for (i = 0; i < SCOREBOARD_ENTRIES; i++)
+        {
+            page = i + 1;
+            if (page < base || page >= base + DISPLAY_ROW_SETS)
+                continue;
+            if (record[i][0] != 0 || record[i][1] != 0 || record[i][2] != 0 || record[i][3] != 0)
+                display_print_text(strings[i], 0, (page - base) * DISPLAY_ROW_BITS);
+        }
+        display_update();
+    }
+}
@@ -0,0 +1,62 @@
+/**
+ * render.h
+ * 
+ * Draws the game screen: the border and HUD as a background layer, and
+ * the paddles and the ball on top of it.
+*/
+#ifndef RENDER_HEADER
+#define RENDER_HEADER
+
+#include "display.h"
+#include "pong.h"
+#include "score.h"
+
+/* -------------------------------------------- */
+/* ------- Extern variable declarations ------- */
+
+extern const float P_WIDTH;
+extern const float P_HEIGHT;
+extern const float B_WIDTH;
+extern const float B_HEIGHT;
+extern const int SCREEN_OFFSET;
+
+/* --------------------------------------------- */
+/* ----------- Function declarations ----------- */
+
+/**
+ * @brief   Creates the sprites for the paddles and the ball.
+ *          Call once at start up.
+*/
+void render_init();
+
+/**
+ * @brief   Makes the next call to render_game() build the background
+ *          again, e.g. after something has been drawn over the game.
+*/
+void render_invalidate();
+
+/**
+ * @brief   Draws a frame of the game into the screen data buffer.
+ *          The border and HUD are only drawn again when a score changed
+ *          or render_invalidate() was called, otherwise just the objects
+ *          that moved are erased and drawn again.
+ * 
+ * @param p1        player 1
+ * @param p2        player 2
+ * @param b         the ball
+*/
+void render_game(struct paddle *p1, struct paddle *p2, struct ball *b);
+
+/**
+ * @brief   Draws the whole highscore list into the display's memory, the
+ *          header on page 0 and entry i on page i + 1, so that it can be
+ *          scrolled with display_set_start_line() without drawing or
+ *          sending anything more. Leaves the page base at 0.
+ * 
+ * @param record    the records, entries that are all zero are left empty
+ * @param strings   the records as text, see score_convert_to_strings()
+*/
+void render_highscores(uint8_t record[SCOREBOARD_ENTRIES][SCORE_RECORD_SIZE],
+                       char strings[SCOREBOARD_ENTRIES][SCORE_STR_SIZE + 1]);
+
+#endif /* RENDER_HEADER */
@@ -0,0 +1,69 @@
+/**
+ * sampler.c
+ * Sampling profiler, see sampler.h.
+*/
+#include <pic32mx.h>
+#include <string.h>
+#include "sampler.h"
+#include "tick.h"
+#include "cp0.h"
+
+/* --------------------------------------------- */
+/* -------------- Local variables -------------- */
+
+static struct sampler_histogram histogram;
+
+/* ---------------------------------------------- */
+/* ------------ Function definitions ------------ */
+
+void sampler_start(uint16_t rate)
+{
+    if (rate < TICK_MIN_TIMER_RATE)
+        rate = TICK_MIN_TIMER_RATE;
+
+    T4CON = 0x0;
+    T4CONSET = 0x6 << 4; // Prescaling 1:64
+    TMR4 = 0x0;
+    PR4 = TICK_TIMER_HZ / rate - 1;
+    IFSCLR(0) = SAMPLER_IRQ;
+    IECSET(0) = SAMPLER_IRQ;
+    T4CONSET = 0x8000; // start timer
+}
+
+void sampler_stop(void)
+{
+    T4CONCLR = 0x8000; // stop timer
+    IECCLR(0) = SAMPLER_IRQ;
+}
+
+void sampler_reset(void)
+{
+    IECCLR(0) = SAMPLER_IRQ;
+    memset(&histogram, 0, sizeof(histogram));
+    if (T4CON & 0x8000)
+        IECSET(0) = SAMPLER_IRQ;
+}
+
+const struct sampler_histogram *sampler_get(void)
+{
+    return &histogram;
+}
+
+void sampler_isr(void)
+{
+    uint32_t offset = cp0_get_epc() - SAMPLER_FLASH_BASE;
+    uint16_t *bucket;
+
+    IFSCLR(0) = SAMPLER_IRQ;
+
+    histogram.samples++;
+    // Below the base wraps around to far above the end
+    if (offset >= SAMPLER_FLASH_SIZE)
+    {
+        histogram.other++;
+        return;
+    }
+    bucket = &histogram.buckets[offset >> SAMPLER_BUCKET_SHIFT];
+    if (*bucket < 0xFFFF)
+        (*bucket)++;
+}
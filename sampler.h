@@ -0,0 +1,85 @@
+/**
+ * sampler.h
+ *
+ * A sampling profiler. Timer 4 interrupts at a steady rate and the address
+ * the main loop was interrupted at, EPC, is counted in a histogram of
+ * program flash, SAMPLER_BUCKET bytes per bucket. With the symbols of
+ * outfile.elf the buckets show where the time goes, also in code nobody
+ * thought to time, like the soft-float routines behind cos() and fabs().
+ * Interrupt handlers are never sampled, interrupts don't nest.
+ *
+ * The histogram is written out as text for host/symbolize:
+ *
+ *      bucket 256              bytes per bucket
+ *      other 12                samples outside of program flash
+ *      9d001200 431            a bucket's first address and its samples
+*/
+#ifndef SAMPLER_HEADER
+#define SAMPLER_HEADER
+
+#include <stdint.h>
+
+/* --------------------------------------------- */
+/* ---------------- Definitions ---------------- */
+
+/* Program flash, as the CPU runs it through KSEG0 */
+#define SAMPLER_FLASH_BASE 0x9D000000
+#define SAMPLER_FLASH_SIZE 0x20000
+#define SAMPLER_BUCKET_SHIFT 8
+#define SAMPLER_BUCKET (1 << SAMPLER_BUCKET_SHIFT)
+#define SAMPLER_BUCKETS (SAMPLER_FLASH_SIZE >> SAMPLER_BUCKET_SHIFT)
+
+/* Samples a second. Not a multiple of the frame rate, so the samples don't
+   fall on the same point of every frame */
+#define SAMPLER_DEFAULT_RATE 997
+
+/* Timer 4 interrupt, bit in IFS(0)/IEC(0), and its priority. Below the
+   other sources, they aren't sampled anyway */
+#define SAMPLER_IRQ (1 << 16)
+#define SAMPLER_PRIORITY 2
+
+/* --------------------------------------------- */
+/* ----------- Variable declarations ----------- */
+
+/**
+ * @brief   The samples, see sampler_get().
+*/
+struct sampler_histogram
+{
+    uint32_t samples;                  // Taken in all
+    uint32_t other;                    // Outside of program flash
+    uint16_t buckets[SAMPLER_BUCKETS]; // Stop counting at 0xFFFF
+};
+
+/* --------------------------------------------- */
+/* ----------- Function declarations ----------- */
+
+/**
+ * @brief   Starts sampling with Timer 4. The interrupt is installed
+ *          separately, see interrupt.h.
+ *
+ * @param rate      samples a second, at least 20
+*/
+void sampler_start(uint16_t rate);
+
+/**
+ * @brief   Stops sampling, the histogram is kept.
+*/
+void sampler_stop(void);
+
+/**
+ * @brief   Clears the histogram.
+*/
+void sampler_reset(void);
+
+/**
+ * @return  the histogram, it keeps changing while sampling
+*/
+const struct sampler_histogram *sampler_get(void);
+
+/**
+ * @brief   Timer 4 interrupt handler.
+*/
+void sampler_isr(void);
+
+#endif /* SAMPLER_HEADER */
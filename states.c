@@ -0,0 +1,69 @@
+/**
+ * states.c
+ * State machine for the screens, see states.h.
+*/
+#include <string.h>
+#include <stdbool.h>
+#include "states.h"
+
+/* --------------------------------------------- */
+/* -------------- Local variables -------------- */
+
+static const struct state *states;
+static uint8_t current;
+static uint8_t drawn_view[STATE_VIEW_MAX]; // The view as last rendered
+static bool redraw;
+
+/* ---------------------------------------------- */
+/* ------------ Function definitions ------------ */
+
+void states_start(const struct state *table, uint8_t first)
+{
+    states = table;
+    current = first;
+    redraw = true;
+    if (states[current].enter)
+        states[current].enter();
+}
+
+void states_update(void)
+{
+    const struct state *state = &states[current];
+    uint8_t next = state->update ? state->update() : STATE_SAME;
+
+    if (next == STATE_SAME || next == current)
+        return;
+    if (state->exit)
+        state->exit();
+    current = next;
+    redraw = true;
+    if (states[current].enter)
+        states[current].enter();
+}
+
+void states_render(void)
+{
+    const struct state *state = &states[current];
+
+    if (!state->render)
+        return;
+    // Nothing on the screen would change, so nothing is drawn or sent
+    if (!redraw && (!state->view || memcmp(drawn_view, state->view, state->view_size) == 0))
+        return;
+
+    // Cleared first, so that a render that couldn't finish can ask again
+    redraw = false;
+    state->render();
+    if (state->view)
+        memcpy(drawn_view, state->view, state->view_size);
+}
+
+uint8_t states_current(void)
+{
+    return current;
+}
+
+void states_redraw(void)
+{
+    redraw = true;
+}
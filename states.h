@@ -0,0 +1,85 @@
+/**
+ * states.h
+ *
+ * A table-driven state machine for the screens of the game. Each state
+ * has handlers, called by states_update() and states_render() once a
+ * frame:
+ *
+ *      enter()     when the state is entered
+ *      update()    every frame, returns the state to go to
+ *      render()    draws the screen and sends it, only when the state has
+ *                  just been entered or its view has changed
+ *      exit()      when the state is left
+ *
+ * The view is the state's view model, the values its screen is drawn
+ * from. states_render() keeps a copy of the view as it was last drawn, so a
+ * screen that hasn't changed is neither drawn nor sent again and a static
+ * screen costs no more than its update().
+*/
+#ifndef STATES_HEADER
+#define STATES_HEADER
+
+#include <stdint.h>
+
+/* --------------------------------------------- */
+/* ---------------- Definitions ---------------- */
+
+/* Returned by update() to stay in the state */
+#define STATE_SAME 0xFF
+/* Largest view, in bytes */
+#define STATE_VIEW_MAX 16
+
+/* --------------------------------------------- */
+/* ----------- Variable declarations ----------- */
+
+/**
+ * @brief   A state, one entry of the table given to states_start(). Any of
+ *          the handlers can be NULL.
+*/
+struct state
+{
+    const char *name;
+    void (*enter)(void);
+    uint8_t (*update)(void); // The next state or STATE_SAME
+    void (*render)(void);
+    void (*exit)(void);
+    const void *view;        // NULL if the screen is only drawn when entered
+    uint8_t view_size;       // At most STATE_VIEW_MAX, without padding
+};
+
+/* --------------------------------------------- */
+/* ----------- Function declarations ----------- */
+
+/**
+ * @brief   Enters the first state.
+ *
+ * @param table     the states, indexed by state number
+ * @param first     the state to start in
+*/
+void states_start(const struct state *table, uint8_t first);
+
+/**
+ * @brief   Updates the current state and moves to the state it returns.
+*/
+void states_update(void);
+
+/**
+ * @brief   Renders the current state if it was just entered or its view
+ *          has changed. A frame that isn't rendered, see deadline.h, is
+ *          simply drawn by the next call.
+*/
+void states_render(void);
+
+/**
+ * @return  the current state
+*/
+uint8_t states_current(void);
+
+/**
+ * @brief   Makes the next states_render() render even if the view hasn't
+ *          changed, e.g. when something else has drawn over the screen.
+ *          A render can call it to be tried again the next frame.
+*/
+void states_redraw(void);
+
+#endif /* STATES_HEADER */
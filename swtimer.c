@@ -0,0 +1,132 @@
+/**
+ * swtimer.c
+ * Software timers, see swtimer.h.
+*/
+#include <pic32mx.h>
+#include <stddef.h>
+#include "swtimer.h"
+#include "tick.h"
+
+/* --------------------------------------------- */
+/* ---------------- Definitions ---------------- */
+
+#define SLOT(tick) ((tick) & (SWTIMER_SLOTS - 1))
+
+/* The wheel is turned by the tick interrupt, which is held off while the
+   main loop changes it */
+#define LOCK() (IECCLR(0) = TICK_IRQ)
+#define UNLOCK() (IECSET(0) = TICK_IRQ)
+
+/* --------------------------------------------- */
+/* -------------- Local variables -------------- */
+
+static struct swtimer *slots[SWTIMER_SLOTS];
+static volatile uint32_t now; // Ticks since start
+
+/* --------------------------------------------- */
+/* -------------- Local functions -------------- */
+
+/* Number of frames in ms milliseconds, rounded up, at least 1 */
+static uint32_t swtimer_ticks(uint32_t ms);
+static void swtimer_insert(struct swtimer *timer);
+static void swtimer_remove(struct swtimer *timer);
+
+/* ---------------------------------------------- */
+/* ------------ Function definitions ------------ */
+
+void swtimer_start(struct swtimer *timer, uint32_t ms, uint32_t period_ms,
+                   void (*callback)(struct swtimer *timer))
+{
+    LOCK();
+    if (timer->active)
+        swtimer_remove(timer);
+    timer->expires = now + swtimer_ticks(ms);
+    timer->period = period_ms ? swtimer_ticks(period_ms) : 0;
+    timer->callback = callback;
+    timer->fired = false;
+    timer->active = true;
+    swtimer_insert(timer);
+    UNLOCK();
+}
+
+void swtimer_stop(struct swtimer *timer)
+{
+    LOCK();
+    if (timer->active)
+        swtimer_remove(timer);
+    timer->active = false;
+    UNLOCK();
+}
+
+bool swtimer_running(const struct swtimer *timer)
+{
+    return timer->active;
+}
+
+bool swtimer_fired(struct swtimer *timer)
+{
+    bool fired;
+
+    LOCK();
+    fired = timer->fired;
+    timer->fired = false;
+    UNLOCK();
+    return fired;
+}
+
+void swtimer_tick(void)
+{
+    struct swtimer **link;
+    struct swtimer *timer;
+
+    now++;
+    link = &slots[SLOT(now)];
+    while (*link)
+    {
+        timer = *link;
+        // Due in a later turn of the wheel
+        if (timer->expires != now)
+        {
+            link = &timer->next;
+            continue;
+        }
+
+        *link = timer->next;
+        timer->fired = true;
+        if (timer->period)
+        {
+            // Always a later tick, so it isn't met again in this turn
+            timer->expires = now + timer->period;
+            swtimer_insert(timer);
+        }
+        else
+            timer->active = false;
+
+        if (timer->callback)
+            timer->callback(timer);
+    }
+}
+
+static uint32_t swtimer_ticks(uint32_t ms)
+{
+    uint32_t ticks = (ms * tick_get_rate() + 999) / 1000;
+    return ticks ? ticks : 1;
+}
+
+static void swtimer_insert(struct swtimer *timer)
+{
+    struct swtimer **slot = &slots[SLOT(timer->expires)];
+
+    timer->next = *slot;
+    *slot = timer;
+}
+
+static void swtimer_remove(struct swtimer *timer)
+{
+    struct swtimer **link = &slots[SLOT(timer->expires)];
+
+    while (*link && *link != timer)
+        link = &(*link)->next;
+    if (*link)
+        *link = timer->next;
+}
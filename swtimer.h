@@ -0,0 +1,79 @@
+/**
+ * swtimer.h
+ *
+ * Software timers on a timer wheel turned by the frame tick, see tick.h.
+ * A timer fires once or periodically; when it does its flag is set and,
+ * if it has one, its callback is called. Nothing spins while a timer runs,
+ * the main loop keeps sleeping in tick_wait() between frames.
+ *
+ * Timers count whole frames, so they are only as fine as the frame rate
+ * (33 ms at 30 Hz) and keep their length in frames if the rate changes.
+*/
+#ifndef SWTIMER_HEADER
+#define SWTIMER_HEADER
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* --------------------------------------------- */
+/* ---------------- Definitions ---------------- */
+
+/* Slots in the wheel, a power of two. A timer is only looked at when the
+   wheel passes its slot, so it costs nothing the other frames */
+#define SWTIMER_SLOTS 16
+
+/* --------------------------------------------- */
+/* ----------- Variable declarations ----------- */
+
+/**
+ * @brief   A software timer. Owned by the caller, usually static, and
+ *          only changed through the swtimer_* functions.
+*/
+struct swtimer
+{
+    struct swtimer *next;        // In the same slot
+    uint32_t expires;            // Tick it fires at
+    uint32_t period;             // Ticks, 0 for a one-shot timer
+    void (*callback)(struct swtimer *timer);
+    volatile bool active;
+    volatile bool fired;
+};
+
+/* --------------------------------------------- */
+/* ----------- Function declarations ----------- */
+
+/**
+ * @brief   Starts a timer, or starts it over if it is already running.
+ *
+ * @param ms        time until it first fires, at least one frame
+ * @param period_ms time between firings after that, 0 to fire once
+ * @param callback  called from the tick interrupt when it fires, or NULL
+ *                  to only set the flag, see swtimer_fired()
+*/
+void swtimer_start(struct swtimer *timer, uint32_t ms, uint32_t period_ms,
+                   void (*callback)(struct swtimer *timer));
+
+/**
+ * @brief   Stops a timer. Its flag is left as it is.
+*/
+void swtimer_stop(struct swtimer *timer);
+
+/**
+ * @return  whether a timer is started and hasn't fired yet, or is periodic
+*/
+bool swtimer_running(const struct swtimer *timer);
+
+/**
+ * @brief   Checks and clears a timer's flag.
+ *
+ * @return  whether it has fired since the last call
+*/
+bool swtimer_fired(struct swtimer *timer);
+
+/**
+ * @brief   Turns the wheel one frame, firing the timers that are due.
+ *          Called from tick_isr().
+*/
+void swtimer_tick(void);
+
+#endif /* SWTIMER_HEADER */
@@ -0,0 +1,229 @@
+/**
+ * telemetry.c
+ * Telemetry over UART1, see telemetry.h.
+*/
+#include <pic32mx.h>
+#include "telemetry.h"
+#include "tick.h"
+#include "profile.h"
+#include "sampler.h"
+#include "boot.h"
+
+/* --------------------------------------------- */
+/* ---------------- Definitions ---------------- */
+
+#define RING_MASK (TELEMETRY_RING_SIZE - 1)
+/* Sync, type, length and checksum */
+#define RECORD_OVERHEAD 4
+
+/* Keeps the compiler from moving the record's stores past the index that
+   hands it over */
+#define BARRIER() __asm__ volatile("" ::: "memory")
+
+/* --------------------------------------------- */
+/* -------------- Local variables -------------- */
+
+/* One writer, the main loop, and one reader, the interrupt, like the
+   input queue. Each moves only its own index. */
+static uint8_t ring[TELEMETRY_RING_SIZE];
+static volatile uint16_t ring_head; // Next byte written
+static volatile uint16_t ring_tail; // Next byte sent
+static uint32_t dropped;
+
+static uint16_t next_bucket; // Where telemetry_samples() goes on
+
+/* --------------------------------------------- */
+/* -------------- Local functions -------------- */
+
+static uint8_t *put16(uint8_t *p, uint16_t value);
+static uint8_t *put32(uint8_t *p, uint32_t value);
+
+/* ---------------------------------------------- */
+/* ------------ Function definitions ------------ */
+
+void telemetry_init(uint32_t baud)
+{
+    U1MODE = 0x0;
+    U1STA = 0x0;
+    U1BRG = TICK_PBCLK_HZ / (4 * baud) - 1;
+    U1MODESET = 0x8;    // BRGH, 4 clocks per bit
+    U1STASET = 0x400;   // UTXEN
+    IFSCLR(0) = TELEMETRY_IRQ;
+    U1MODESET = 0x8000; // ON
+}
+
+bool telemetry_send(uint8_t type, const uint8_t *payload, uint8_t length)
+{
+    uint16_t head = ring_head;
+    uint16_t free = (ring_tail - head - 1) & RING_MASK;
+    uint8_t sum = type + length;
+    uint8_t i;
+
+    if (free < length + RECORD_OVERHEAD)
+    {
+        dropped++;
+        return false;
+    }
+
+    ring[head] = TELEMETRY_SYNC;
+    ring[(head + 1) & RING_MASK] = type;
+    ring[(head + 2) & RING_MASK] = length;
+    head = (head + 3) & RING_MASK;
+    for (i = 0; i < length; i++)
+    {
+        ring[head] = payload[i];
+        sum += payload[i];
+        head = (head + 1) & RING_MASK;
+    }
+    ring[head] = sum;
+    BARRIER();
+    ring_head = (head + 1) & RING_MASK;
+
+    // The interrupt turns itself off when it runs out of bytes
+    IECSET(0) = TELEMETRY_IRQ;
+    return true;
+}
+
+void telemetry_frame(uint32_t frame, uint32_t us, uint16_t bytes, uint8_t state)
+{
+    uint8_t payload[15];
+    uint8_t *p = payload;
+
+    p = put32(p, frame);
+    p = put32(p, us);
+    p = put16(p, bytes);
+    *p++ = state;
+    p = put32(p, dropped);
+    telemetry_send(TELEMETRY_FRAME, payload, p - payload);
+}
+
+void telemetry_score(uint8_t score1, uint8_t score2)
+{
+    uint8_t payload[2] = {score1, score2};
+
+    telemetry_send(TELEMETRY_SCORE, payload, sizeof(payload));
+}
+
+void telemetry_ai(float y, float direction, float predicted_y)
+{
+    uint8_t payload[6];
+    uint8_t *p = payload;
+
+    p = put16(p, (int16_t)(y * 256));
+    p = put16(p, (int16_t)(direction * 256));
+    p = put16(p, (int16_t)(predicted_y * 256));
+    telemetry_send(TELEMETRY_AI, payload, p - payload);
+}
+
+void telemetry_profile(uint8_t section)
+{
+#if PROFILE
+    const struct profile_stats *s = profile_get(section);
+    uint8_t payload[17];
+    uint8_t *p = payload;
+
+    *p++ = section;
+    p = put32(p, s->count);
+    p = put32(p, s->min);
+    p = put32(p, s->max);
+    p = put32(p, s->count ? s->total / s->count : 0);
+    telemetry_send(TELEMETRY_PROFILE, payload, p - payload);
+#endif
+}
+
+void telemetry_samples(void)
+{
+    const struct sampler_histogram *h = sampler_get();
+    uint8_t payload[TELEMETRY_MAX_PAYLOAD];
+    uint8_t *p = payload;
+    uint16_t bucket = next_bucket;
+    uint8_t pairs = 0;
+
+    p = put32(p, h->samples);
+    p = put32(p, h->other);
+    *p++ = SAMPLER_BUCKET_SHIFT;
+    for (; bucket < SAMPLER_BUCKETS && pairs < TELEMETRY_SAMPLE_PAIRS; bucket++)
+    {
+        if (!h->buckets[bucket])
+            continue;
+        p = put16(p, bucket);
+        p = put16(p, h->buckets[bucket]);
+        pairs++;
+    }
+    // Sent again if it was dropped, the counts are totals anyway
+    if (telemetry_send(TELEMETRY_SAMPLES, payload, p - payload))
+        next_bucket = bucket < SAMPLER_BUCKETS ? bucket : 0;
+}
+
+void telemetry_boot(void)
+{
+    const struct boot_event *events;
+    uint8_t count = boot_get_trace(&events);
+    uint8_t payload[TELEMETRY_MAX_PAYLOAD];
+    uint8_t *p;
+    uint8_t i, j;
+
+    for (i = 0; i < count; i++)
+    {
+        p = payload;
+        *p++ = i;
+        *p++ = count;
+        p = put32(p, events[i].us);
+        for (j = 0; events[i].name[j] && p < payload + sizeof(payload); j++)
+            *p++ = events[i].name[j];
+        telemetry_send(TELEMETRY_BOOT, payload, p - payload);
+    }
+}
+
+void telemetry_tick(void)
+{
+    struct tick_stats stats;
+    uint8_t payload[13];
+    uint8_t *p = payload;
+
+    tick_get_stats(&stats);
+    p = put32(p, cp0_get_count());
+    p = put32(p, stats.interrupts);
+    p = put32(p, stats.isr_cycles);
+    *p++ = TICK_LEGACY;
+    telemetry_send(TELEMETRY_TICK, payload, p - payload);
+}
+
+uint32_t telemetry_dropped(void)
+{
+    return dropped;
+}
+
+void telemetry_isr(void)
+{
+    uint16_t tail = ring_tail;
+
+    // Fill the transmit FIFO
+    while (tail != ring_head && !(U1STA & 0x200)) // UTXBF
+    {
+        U1TXREG = ring[tail];
+        tail = (tail + 1) & RING_MASK;
+    }
+    ring_tail = tail;
+    if (tail == ring_head)
+    {
+        IECCLR(0) = TELEMETRY_IRQ;
+        // A record queued right then would wait for the next one
+        if (tail != ring_head)
+            IECSET(0) = TELEMETRY_IRQ;
+    }
+    IFSCLR(0) = TELEMETRY_IRQ;
+}
+
+static uint8_t *put16(uint8_t *p, uint16_t value)
+{
+    p[0] = value;
+    p[1] = value >> 8;
+    return p + 2;
+}
+
+static uint8_t *put32(uint8_t *p, uint32_t value)
+{
+    p = put16(p, value);
+    return put16(p, value >> 16);
+}
@@ -0,0 +1,132 @@
+/**
+ * telemetry.h
+ *
+ * Telemetry records streamed over UART1, the board's USB serial port. A
+ * record is put in a ring buffer and returns at once, the UART1 transmit
+ * interrupt sends the buffer in the background. A record that doesn't fit
+ * is dropped and counted, so the game never waits for the serial port.
+ * host/telemetry_decode reads the stream.
+ *
+ * A record on the wire, numbers little-endian:
+ *
+ *      0xA5 type length payload[length] checksum
+ *
+ * with the checksum the low byte of the sum of type, length and payload.
+ * The payloads by type:
+ *
+ *      FRAME       u32 frame, u32 time of the frame before in us, sending
+ *                  its records included, u16 bytes of the last flush, u8
+ *                  state, u32 records dropped so far
+ *      SCORE       u8 player 1, u8 player 2
+ *      AI          s16 paddle y, s16 direction, s16 predicted ball y, all
+ *                  in 1/256 pixels
+ *      PROFILE     u8 section, u32 count, u32 min, u32 max, u32 mean, in
+ *                  Count ticks, see profile.h
+ *      SAMPLES     u32 samples, u32 other, u8 bucket shift, then u16 bucket
+ *                  and u16 count for buckets that aren't empty, see
+ *                  sampler.h
+ *      BOOT        u8 step, u8 steps, u32 us since start-up began, then
+ *                  the step's name, see boot.h
+ *      TICK        u32 Count, u32 Timer 2 interrupts, u32 Count ticks
+ *                  spent in tick_isr(), u8 TICK_LEGACY, see tick.h
+*/
+#ifndef TELEMETRY_HEADER
+#define TELEMETRY_HEADER
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* --------------------------------------------- */
+/* ---------------- Definitions ---------------- */
+
+#define TELEMETRY_BAUD 115200
+#define TELEMETRY_SYNC 0xA5
+/* Bytes the ring buffer holds, a power of two */
+#define TELEMETRY_RING_SIZE 1024
+#define TELEMETRY_MAX_PAYLOAD 80
+
+/* Record types */
+#define TELEMETRY_FRAME 1
+#define TELEMETRY_SCORE 2
+#define TELEMETRY_AI 3
+#define TELEMETRY_PROFILE 4
+#define TELEMETRY_SAMPLES 5
+#define TELEMETRY_BOOT 6
+#define TELEMETRY_TICK 7
+
+/* Buckets a SAMPLES record holds at most */
+#define TELEMETRY_SAMPLE_PAIRS ((TELEMETRY_MAX_PAYLOAD - 9) / 4)
+
+/* UART1 transmit interrupt, bit in IFS(0)/IEC(0), and its priority */
+#define TELEMETRY_IRQ (1 << 28)
+#define TELEMETRY_PRIORITY 3
+
+/* --------------------------------------------- */
+/* ----------- Function declarations ----------- */
+
+/**
+ * @brief   Sets up UART1 to send at baud, 8N1. The interrupt is installed
+ *          separately, see interrupt.h.
+*/
+void telemetry_init(uint32_t baud);
+
+/**
+ * @brief   Queues a record.
+ *
+ * @param type      TELEMETRY_FRAME etc.
+ * @param payload   length bytes
+ * @return  false if it didn't fit and was dropped
+*/
+bool telemetry_send(uint8_t type, const uint8_t *payload, uint8_t length);
+
+/**
+ * @brief   Queues a FRAME record.
+*/
+void telemetry_frame(uint32_t frame, uint32_t us, uint16_t bytes, uint8_t state);
+
+/**
+ * @brief   Queues a SCORE record.
+*/
+void telemetry_score(uint8_t score1, uint8_t score2);
+
+/**
+ * @brief   Queues an AI record, see pong_ai_get_decision().
+*/
+void telemetry_ai(float y, float direction, float predicted_y);
+
+/**
+ * @brief   Queues a PROFILE record of a section.
+*/
+void telemetry_profile(uint8_t section);
+
+/**
+ * @brief   Queues a SAMPLES record with the next buckets of the sampling
+ *          profiler that aren't empty, starting over at the first bucket
+ *          after the last. Call regularly to send all of them.
+*/
+void telemetry_samples(void);
+
+/**
+ * @brief   Queues a BOOT record for every step of the start-up trace, see
+ *          boot_get_trace(). Call once, after the first frame is marked.
+*/
+void telemetry_boot(void);
+
+/**
+ * @brief   Queues a TICK record with the interrupt load of the frame
+ *          clock, see tick_get_stats(). The decoder works out the load
+ *          between two of them.
+*/
+void telemetry_tick(void);
+
+/**
+ * @return  records dropped because the ring buffer was full
+*/
+uint32_t telemetry_dropped(void);
+
+/**
+ * @brief   UART1 interrupt handler.
+*/
+void telemetry_isr(void);
+
+#endif /* TELEMETRY_HEADER */
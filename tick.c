@@ -0,0 +1,219 @@
+/**
+ * tick.c
+ * The frame clock, see tick.h.
+*/
+#include <pic32mx.h>
+#include "tick.h"
+#include "cp0.h"
+#include "swtimer.h"
+
+/* --------------------------------------------- */
+/* -------------- Local variables -------------- */
+
+static uint16_t frame_rate;
+static uint8_t subticks = 1;      // Timer 2 interrupts per frame
+static volatile uint8_t subtick;  // Interrupts into the current frame
+static uint16_t subtick_rate;
+static void (*volatile subtick_handler)(void);
+
+#if TICK_LEGACY
+static uint16_t legacy_period;         // 10 us interrupts per subtick
+static volatile uint16_t legacy_count; // ...into the current one
+#endif
+
+static volatile uint8_t frames_pending;
+static volatile struct tick_stats stats;
+
+/* The microsecond clock: us_base microseconds had passed when Count was
+   count_base. Moved forward every interrupt, so Count never wraps around
+   in between. sequence changes every time they do. */
+static volatile uint32_t us_base;
+static volatile uint32_t count_base;
+static volatile uint32_t sequence;
+
+/* --------------------------------------------- */
+/* -------------- Local functions -------------- */
+
+/* Programs Timer 2 for frame_rate * subticks interrupts a second */
+static void tick_program_timer(void);
+/* Sleeps until the next interrupt, unless a frame is already pending */
+static void tick_idle(void);
+
+/* ---------------------------------------------- */
+/* ------------ Function definitions ------------ */
+
+void tick_init(uint16_t rate)
+{
+    T2CON = 0x0;
+#if TICK_LEGACY
+    T2CONSET = 0x4 << 4; // Prescaling 1:16
+#else
+    T2CONSET = 0x6 << 4; // Prescaling 1:64
+#endif
+
+    IPCCLR(2) = 0x1F;
+    IPCSET(2) = TICK_PRIORITY << 2;
+    IFSCLR(0) = TICK_IRQ;
+    IECSET(0) = TICK_IRQ;
+
+    count_base = cp0_get_count();
+    tick_set_rate(rate);
+}
+
+void tick_set_rate(uint16_t rate)
+{
+    if (rate < TICK_MIN_TIMER_RATE)
+        rate = TICK_MIN_TIMER_RATE;
+    frame_rate = rate;
+    tick_set_subtick(subtick_rate, subtick_handler);
+}
+
+uint16_t tick_get_rate(void)
+{
+    return frame_rate;
+}
+
+void tick_set_subtick(uint16_t rate, void (*handler)(void))
+{
+    uint16_t n = 1;
+
+    if (handler && rate > frame_rate)
+        n = (rate + frame_rate / 2) / frame_rate;
+    if (n > TICK_MAX_SUBTICKS)
+        n = TICK_MAX_SUBTICKS;
+
+    IECCLR(0) = TICK_IRQ;
+    subtick_rate = handler ? rate : 0;
+    subtick_handler = handler;
+    subticks = n;
+    tick_program_timer();
+    IECSET(0) = TICK_IRQ;
+}
+
+uint8_t tick_wait(void)
+{
+    uint8_t frames;
+
+    /* Any interrupt wakes the CPU, so the loop sleeps again until the
+       tick has counted a frame. tick_idle() checks with interrupts
+       disabled, a tick is never slept through. */
+    while (!frames_pending)
+        tick_idle();
+
+    IECCLR(0) = TICK_IRQ;
+    frames = frames_pending;
+    frames_pending = 0;
+    stats.missed += frames - 1;
+    IECSET(0) = TICK_IRQ;
+    return frames;
+}
+
+uint32_t tick_frames(void)
+{
+    return stats.frames;
+}
+
+uint32_t tick_us(void)
+{
+    uint32_t seq, base, count, now;
+
+    do
+    {
+        seq = sequence;
+        base = us_base;
+        count = count_base;
+        now = cp0_get_count();
+    } while (seq != sequence);
+
+    return base + (now - count) / CP0_TICKS_PER_US;
+}
+
+uint32_t tick_count_to_us(uint32_t count)
+{
+    return tick_us() - (cp0_get_count() - count) / CP0_TICKS_PER_US;
+}
+
+void tick_get_stats(struct tick_stats *out)
+{
+    IECCLR(0) = TICK_IRQ;
+    out->frames = stats.frames;
+    out->missed = stats.missed;
+    out->interrupts = stats.interrupts;
+    out->isr_cycles = stats.isr_cycles;
+    IECSET(0) = TICK_IRQ;
+}
+
+void tick_isr(void)
+{
+    uint32_t start = cp0_get_count();
+    uint32_t elapsed;
+
+    IFSCLR(0) = TICK_IRQ;
+
+#if TICK_LEGACY
+    // Counted up to the subtick like the old handler did
+    if (++legacy_count < legacy_period)
+    {
+        stats.interrupts++;
+        stats.isr_cycles += cp0_get_count() - start;
+        return;
+    }
+    legacy_count = 0;
+#endif
+
+    elapsed = (start - count_base) / CP0_TICKS_PER_US;
+    us_base += elapsed;
+    count_base += elapsed * CP0_TICKS_PER_US;
+    sequence++;
+
+    if (subtick_handler)
+        subtick_handler();
+
+    if (++subtick >= subticks)
+    {
+        subtick = 0;
+        stats.frames++;
+        if (frames_pending < 0xFF)
+            frames_pending++;
+        swtimer_tick();
+    }
+
+    stats.interrupts++;
+    stats.isr_cycles += cp0_get_count() - start;
+}
+
+static void tick_program_timer(void)
+{
+    T2CONCLR = 0x8000; // stop timer
+    TMR2 = 0x0;
+#if TICK_LEGACY
+    PR2 = TICK_PBCLK_HZ / TICK_LEGACY_PRESCALER / TICK_LEGACY_HZ - 1;
+    legacy_period = TICK_LEGACY_HZ / ((uint32_t)frame_rate * subticks);
+    legacy_count = 0;
+#else
+    PR2 = TICK_TIMER_HZ / ((uint32_t)frame_rate * subticks) - 1;
+#endif
+    subtick = 0;
+    T2CONSET = 0x8000; // start timer
+}
+
+static void tick_idle(void)
+{
+#ifdef __mips__
+    uint32_t status;
+
+    /* With OSCCON SLPEN clear WAIT enters Idle mode: the CPU stops and the
+       peripherals keep running until an interrupt wakes it.
+
+       The check and the WAIT run with interrupts disabled. Otherwise a
+       tick that comes between them would be handled first and the CPU
+       would then sleep through the frame it counted, since with one
+       subtick Timer 2 only interrupts once a frame. A pending interrupt
+       still ends WAIT on the M4K while they are disabled, and is taken
+       as soon as Status is restored. */
+    __asm__ volatile("di %0\n\tehb" : "=r"(status) : : "memory");
+    if (!frames_pending)
+        __asm__ volatile("wait");
+    __asm__ volatile("mtc0 %0, $12\n\tehb" : : "r"(status) : "memory");
+#endif
+}
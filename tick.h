@@ -0,0 +1,130 @@
+/**
+ * tick.h
+ *
+ * The frame clock. Timer 2 interrupts once per frame, or a few times per
+ * frame when something has to run at a steady rate faster than the game,
+ * like greyscale subframes. Between frames the main loop sleeps in
+ * tick_wait(). Every frame also turns the software timers in swtimer.h.
+ * Also keeps a microsecond clock made from the CP0 Count register.
+*/
+#ifndef TICK_HEADER
+#define TICK_HEADER
+
+#include <stdint.h>
+#include <stdbool.h>
+
+/* --------------------------------------------- */
+/* ---------------- Definitions ---------------- */
+
+#define TICK_PBCLK_HZ 80000000
+#define TICK_PRESCALER 64 // Timer 2 counts at 1.25 MHz
+#define TICK_TIMER_HZ (TICK_PBCLK_HZ / TICK_PRESCALER)
+/* PR2 is 16 bits, Timer 2 can't interrupt less often than this (20 Hz) */
+#define TICK_MIN_TIMER_RATE (TICK_TIMER_HZ / 0x10000 + 1)
+/* Most Timer 2 interrupts per frame, see tick_set_subtick() */
+#define TICK_MAX_SUBTICKS 32
+
+/* 1 to run Timer 2 the way the game did before this clock, for measuring
+   what that cost: an interrupt every 10 us at 1:16, and a frame every
+   TICK_LEGACY_HZ / rate of them. tick_get_stats() and the TICK telemetry
+   record count the same in both modes. */
+#ifndef TICK_LEGACY
+#define TICK_LEGACY 0
+#endif
+#define TICK_LEGACY_PRESCALER 16
+#define TICK_LEGACY_HZ 100000
+
+/* Timer 2 interrupt, bit in IFS(0)/IEC(0), and its priority */
+#define TICK_IRQ (1 << 8)
+#define TICK_PRIORITY 4
+
+/* --------------------------------------------- */
+/* ----------- Variable declarations ----------- */
+
+/**
+ * @brief   What the frame clock has done since tick_init(), see
+ *          tick_get_stats().
+*/
+struct tick_stats
+{
+    uint32_t frames;
+    uint32_t missed;     // Frames that passed while the main loop was busy
+    uint32_t interrupts; // Timer 2 interrupts
+    uint32_t isr_cycles; // CP0 Count ticks spent in tick_isr()
+};
+
+/* --------------------------------------------- */
+/* ----------- Function declarations ----------- */
+
+/**
+ * @brief   Starts Timer 2 at the frame rate. Interrupts are enabled
+ *          separately, with enable_interrupt().
+ *
+ * @param rate      frames per second
+*/
+void tick_init(uint16_t rate);
+
+/**
+ * @brief   Changes the frame rate, e.g. between 30, 60 and 120 Hz. The
+ *          current frame starts over and the subtick keeps its rate.
+ *
+ * @param rate      frames per second, at least TICK_MIN_TIMER_RATE
+*/
+void tick_set_rate(uint16_t rate);
+
+/**
+ * @return  frames per second
+*/
+uint16_t tick_get_rate(void);
+
+/**
+ * @brief   Calls handler from the Timer 2 interrupt about rate times a
+ *          second, by making Timer 2 interrupt a whole number of times
+ *          per frame. The number is worked out again when the frame rate
+ *          changes.
+ *
+ * @param rate      calls per second, 0 to stop
+ * @param handler   called with interrupts disabled, keep it short
+*/
+void tick_set_subtick(uint16_t rate, void (*handler)(void));
+
+/**
+ * @brief   Sleeps until the next frame starts. Returns right away if one
+ *          has already started.
+ *
+ * @return  frames started since the last call, more than 1 if the main
+ *          loop was late
+*/
+uint8_t tick_wait(void);
+
+/**
+ * @return  frames started since tick_init()
+*/
+uint32_t tick_frames(void);
+
+/**
+ * @brief   A monotonic clock in microseconds. It wraps around after about
+ *          71 minutes, differences between readings closer than that are
+ *          right.
+*/
+uint32_t tick_us(void);
+
+/**
+ * @brief   Converts a CP0 Count reading, from the last 107 seconds, to the
+ *          time tick_us() gave then.
+*/
+uint32_t tick_count_to_us(uint32_t count);
+
+/**
+ * @brief   Copies the counters. The interrupt load is
+ *          isr_cycles / CP0_COUNT_HZ over the time they were collected.
+*/
+void tick_get_stats(struct tick_stats *stats);
+
+/**
+ * @brief   Timer 2 interrupt handler, call from user_isr() when
+ *          IFS(0) & TICK_IRQ.
+*/
+void tick_isr(void);
+
+#endif /* TICK_HEADER */